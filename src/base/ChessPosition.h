@@ -1,12 +1,18 @@
 #pragma once
 #include "StandardMove.h"
 #include <string>
+#include <cstddef>
 #include <vector>
 #include <optional>
 
 class ChessPosition
 {
 public:
+    /**
+     * Engines are owned and deleted through base class pointers (e.g. by the test suite)
+     */
+    virtual ~ChessPosition() = default;
+
     /**
      * Loads the starting position into the engine
      */
@@ -23,6 +29,18 @@ public:
      */
     virtual std::vector<StandardMove> getLegalMoves() noexcept = 0;
 
+    /**
+     * Maximum number of legal moves in any chess position
+     */
+    static constexpr std::size_t MAX_LEGAL_MOVES = 218;
+
+    /**
+     * Writes the legal moves for the current position to the moves array without allocating
+     * @param capacity size of the moves array (MAX_LEGAL_MOVES always fits every move)
+     * @return number of legal moves (only the first capacity moves are written if there are more)
+     */
+    virtual std::size_t getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept = 0;
+
     /**
      * @return -1 if black is to move, or 1 if white is to move
      */
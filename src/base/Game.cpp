@@ -59,6 +59,15 @@ std::vector<StandardMove> Game::getLegalMoves() noexcept
     return moves;
 }
 
+std::size_t Game::getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept
+{
+    std::size_t count = std::min(capacity, enginePositionMoves.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        moves[i] = StandardMove(enginePositionMoves[i].start(), enginePositionMoves[i].target(), enginePositionMoves[i].promotion());
+    }
+    return enginePositionMoves.size();
+}
+
 int Game::colorToMove() noexcept
 {
     return 1 - 2 * (totalHalfmoves % 2);
@@ -70,7 +79,8 @@ void Game::inputMove(const StandardMove& move)
         throw std::runtime_error("Game is over, cannot input move!");
     }
 
-    for (Move& legalMove : enginePositionMoves) {
+    // The move is copied, enginePositionMoves is refilled with the moves of the new position while it is still being used
+    for (Move legalMove : enginePositionMoves) {
         if (legalMove == move) {
 
             makeMove(legalMove);
@@ -85,11 +95,11 @@ void Game::inputMove(const StandardMove& move)
             // Castling case
             if (legalMove.moving() == color + KING && move.targetSquare - move.startSquare == -2) {
                 algebraic = "O-O-O";
-                enginePositionMoves = legalMoves();
+                legalMoves(enginePositionMoves);
             }
             else if (legalMove.moving() == color + KING && move.targetSquare - move.startSquare == 2) {
                 algebraic = "O-O";
-                enginePositionMoves = legalMoves();
+                legalMoves(enginePositionMoves);
             }
             // General Case
             else {
@@ -128,7 +138,7 @@ void Game::inputMove(const StandardMove& move)
                     }
                 }
 
-                enginePositionMoves = legalMoves();
+                legalMoves(enginePositionMoves);
 
                 if (legalMove.captured()) {
                     algebraic += 'x';
@@ -150,7 +160,7 @@ void Game::inputMove(const StandardMove& move)
             gameMoves.push_back(move);
             gameMovesInAlgebraicNotation.push_back(algebraic);
 
-            currentLegalMoves = getLegalMoves();
+            updateCurrentLegalMoves();
 
 
             // UPDATE POSITION INFO
@@ -661,8 +671,8 @@ void Game::initializeFen(const std::string& fenString)
 
     uint8 c = totalHalfmoves % 2;
 
-    enginePositionMoves = legalMoves();
-    currentLegalMoves = getLegalMoves();
+    legalMoves(enginePositionMoves);
+    updateCurrentLegalMoves();
 }
 
 
@@ -1291,21 +1301,25 @@ moveGeneration:
     return checks;
 }
 
-std::vector<Game::Move> Game::legalMoves()
+void Game::legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves)
 {
-    Move moves[225];
+    Move stack[225];
     uint32 end = 0;
-    generatePseudoLegalMoves(moves, end);
+    generatePseudoLegalMoves(stack, end);
 
-    std::vector<Move> legalMoves;
+    moves.clear();
 
     for (uint32 i = 0; i < end; ++i) {
-        if (isLegal(moves[i])) {
-            legalMoves.push_back(moves[i]);
+        if (isLegal(stack[i])) {
+            moves.push_back(stack[i]);
         }
     }
+}
 
-    return legalMoves;
+void Game::updateCurrentLegalMoves()
+{
+    currentLegalMoves.resize(MAX_LEGAL_MOVES);
+    currentLegalMoves.resize(getLegalMoves(currentLegalMoves.data(), currentLegalMoves.size()));
 }
 
 bool Game::makeMove(Game::Move& move)
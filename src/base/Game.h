@@ -1,6 +1,7 @@
 #pragma once
 #include "ChessPosition.h"
 #include "StandardMove.h"
+#include "MoveList.h"
 
 #include <cstdint>
 #include <optional>
@@ -26,6 +27,8 @@ public:
 
     std::vector<StandardMove> getLegalMoves() noexcept override;
 
+    std::size_t getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept override;
+
     int colorToMove() noexcept override;
 
     void inputMove(const StandardMove& move) override;
@@ -172,7 +175,7 @@ private:
     std::uint_fast8_t numTotalPeices[2];
 
     // Legal moves for the current position stored in the engine
-    std::vector<Move> enginePositionMoves;
+    MoveList<Move, MAX_LEGAL_MOVES> enginePositionMoves;
 
 
     // BOARD METHODS
@@ -185,9 +188,12 @@ private:
     // Returns true of the king was in check
     bool generatePseudoLegalMoves(Move* stack, std::uint_fast32_t& idx) noexcept;
 
-    // Generates legal moves for the current position
+    // Replaces the moves with the legal moves for the current position
     // Not as fast as pseudoLegalMoves() for searching
-    std::vector<Move> legalMoves();
+    void legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves);
+
+    // Fills currentLegalMoves with the legal moves in enginePositionMoves (reusing its storage)
+    void updateCurrentLegalMoves();
 
     // update the board based on the inputted move (must be pseudo legal)
     // returns true if move was legal and process completed
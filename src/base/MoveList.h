@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <utility>
+
+/**
+ * List of moves stored inline (no heap allocation)
+ * The capacity is a compile time bound, chosen from the most moves the list can ever hold
+ * @tparam T move type of the engine
+ */
+template <typename T, std::size_t Capacity>
+class MoveList
+{
+public:
+    static constexpr std::size_t CAPACITY = Capacity;
+
+    MoveList() noexcept : count(0) {}
+
+    /**
+     * Adds a move to the end of the list (the list must not be full)
+     */
+    void push_back(const T& move) noexcept
+    {
+        checkCapacity(count + 1);
+        moves[count++] = move;
+    }
+
+    /**
+     * Constructs a move at the end of the list (the list must not be full)
+     */
+    template <typename... Args>
+    void emplace_back(Args&&... args) noexcept
+    {
+        checkCapacity(count + 1);
+        moves[count++] = T{ std::forward<Args>(args)... };
+    }
+
+    /**
+     * Sets the number of moves in the list, for when the moves were written to data() directly
+     */
+    void resize(std::size_t size) noexcept
+    {
+        checkCapacity(size);
+        count = size;
+    }
+
+    void clear() noexcept
+    {
+        count = 0;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return count;
+    }
+
+    bool empty() const noexcept
+    {
+        return count == 0;
+    }
+
+    /**
+     * @return pointer to the storage, which has room for Capacity moves
+     */
+    T* data() noexcept
+    {
+        return moves;
+    }
+
+    const T* data() const noexcept
+    {
+        return moves;
+    }
+
+    T& operator[](std::size_t idx) noexcept
+    {
+        return moves[idx];
+    }
+
+    const T& operator[](std::size_t idx) const noexcept
+    {
+        return moves[idx];
+    }
+
+    T* begin() noexcept
+    {
+        return moves;
+    }
+
+    T* end() noexcept
+    {
+        return moves + count;
+    }
+
+    const T* begin() const noexcept
+    {
+        return moves;
+    }
+
+    const T* end() const noexcept
+    {
+        return moves + count;
+    }
+
+    /**
+     * Moves the numSorted highest scoring moves to the front of the list from highest to lowest score (every move by default)
+     * Moves with equal scores keep their order, and nothing is allocated (unlike std::stable_sort)
+     * @param score function returning the score of a move
+     */
+    template <typename ScoreFunction>
+    void sortByScore(ScoreFunction score, std::size_t numSorted = Capacity) noexcept
+    {
+        numSorted = std::min(numSorted, count);
+        for (std::size_t i = 0; i < numSorted; ++i) {
+            std::size_t best = i;
+            for (std::size_t j = i + 1; j < count; ++j) {
+                if (score(moves[j]) > score(moves[best])) {
+                    best = j;
+                }
+            }
+            std::rotate(moves + i, moves + best, moves + best + 1);
+        }
+    }
+
+private:
+    /**
+     * Aborts if the list would hold more than Capacity moves
+     * Checked in release builds too, as writing past the end would silently corrupt the memory after the list
+     */
+    static void checkCapacity(std::size_t size) noexcept
+    {
+        if (size > Capacity) {
+            std::fputs("MoveList capacity exceeded!\n", stderr);
+            std::abort();
+        }
+    }
+
+    T moves[Capacity];
+
+    std::size_t count;
+};
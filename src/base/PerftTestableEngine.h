@@ -1,7 +1,11 @@
 #pragma once
 #include "StandardEngine.h"
+#include "StandardMove.h"
 #include <cstdint>
 #include <chrono>
+#include <string>
+#include <vector>
+#include <stdexcept>
 
 class PerftTestableEngine : public StandardEngine
 {
@@ -16,4 +20,24 @@ public:
     virtual std::uint64_t search_perft(int depth) noexcept = 0;
 
     virtual std::uint64_t search_perft(std::chrono::milliseconds thinkTime) noexcept = 0;
+
+    /**
+     * Position a number of moves below the current position, and the root move it is reached by
+     */
+    struct PerftSplit
+    {
+        StandardMove rootMove;
+        std::string fen;
+    };
+
+    /**
+     * Lists every position splitDepth moves below the current position, so a perft can be split into subtrees
+     * The moves are made the way perft makes them, so positions past a draw by the game rules are listed too
+     * Engines that cannot split a perft throw std::logic_error
+     */
+    virtual std::vector<PerftSplit> perftSplit(int splitDepth)
+    {
+        (void)splitDepth;
+        throw std::logic_error("Engine cannot split a perft!");
+    }
 };
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "bitboards.h"
+
+#include <cstdint>
+#include <array>
+#include <stdexcept>
+
+#if defined(BITBOARDS_X64) && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+// MSVC generates the attack tables at compile time (base.vcxproj raises /constexpr:steps)
+// Other compilers stop at their default constexpr limits, so they generate the tables once at startup
+#ifdef _MSC_VER
+#define ATTACK_TABLE_CONSTEXPR constexpr
+#else
+#define ATTACK_TABLE_CONSTEXPR
+#endif
+
+namespace
+{
+    using bitboards::Magic;
+    using bitboards::detail::onBoard;
+
+    // Magic multipliers for every square [0, 63] -> [a1, h8]
+    // Found by random search so that every occupancy maps to a table index of exactly popcount(mask) bits without destructive collisions
+    constexpr std::uint64_t ROOK_MAGIC_NUMBERS[64] = {
+        0x8080102040008000ULL, 0x5440041000200048ULL, 0x008020008010000AULL, 0x0200084200100420ULL,
+        0x0200081020040200ULL, 0x0600019002002824ULL, 0x040050811008020CULL, 0x0100004881000126ULL,
+        0x0005800440008020ULL, 0x2882002042090880ULL, 0x0002802000801004ULL, 0x0240808010000800ULL,
+        0x4480800800040082ULL, 0x0408808004000200ULL, 0x00BA0004A8020001ULL, 0x1106000042040091ULL,
+        0x0020208010400080ULL, 0x0022060045028020ULL, 0x0020008020100080ULL, 0x0202020008102041ULL,
+        0x0C50808008000400ULL, 0x0068808002000400ULL, 0x00510400C8100201ULL, 0x400006000100A444ULL,
+        0x483424818008400AULL, 0x8840008080200040ULL, 0x0800100080802000ULL, 0x0440100080800800ULL,
+        0x4000080080040080ULL, 0x9124040080020080ULL, 0x0089000300040E00ULL, 0x080001020020488CULL,
+        0x9040002040800080ULL, 0x80D0002001400242ULL, 0x0000401901002002ULL, 0x0030220901001000ULL,
+        0x0080580005003100ULL, 0x0022006C0A001008ULL, 0x0802301144001248ULL, 0x0020010042000084ULL,
+        0x4AC0400084228004ULL, 0x0010004020004000ULL, 0x3110004020010100ULL, 0x0598100009050020ULL,
+        0x4200080011010004ULL, 0x0818020004008080ULL, 0x02A0708102040008ULL, 0x5201010080420004ULL,
+        0x100B124063800100ULL, 0x7808200240048980ULL, 0x8800200010008080ULL, 0x1099201001000900ULL,
+        0x0100050010080100ULL, 0x0400800200040080ULL, 0x2040280190020400ULL, 0x00100C0100608200ULL,
+        0x0000201241088202ULL, 0x1040002042801B01ULL, 0x0124090010200041ULL, 0x0831002004081001ULL,
+        0x2003000800021005ULL, 0x80010002040008C1ULL, 0x0208008122081004ULL, 0x4000008844002102ULL,
+    };
+
+    constexpr std::uint64_t BISHOP_MAGIC_NUMBERS[64] = {
+        0x0020011019010028ULL, 0x0122100912208000ULL, 0x1498082308200080ULL, 0x0004106600000000ULL,
+        0x2082021000405600ULL, 0x68508804C0820201ULL, 0xA004140422080010ULL, 0x0120402084202004ULL,
+        0x0000F0101014C080ULL, 0x014002300A022041ULL, 0x000084080A004020ULL, 0x2061949202010083ULL,
+        0x0407820210050008ULL, 0x00500101084008A2ULL, 0x2000040404420880ULL, 0x00090044041C0710ULL,
+        0x0804004030841140ULL, 0x002580A001240100ULL, 0x2081000214090200ULL, 0x0812022C01220050ULL,
+        0x0602001012100010ULL, 0x0003004080454024ULL, 0x0000400088084800ULL, 0x8000800040480850ULL,
+        0x1010040110602230ULL, 0x8428204002044D32ULL, 0x0340240028880200ULL, 0x1804080018220040ULL,
+        0x0C10101041004001ULL, 0x0422208008080100ULL, 0x0010810610941000ULL, 0x0302122002050140ULL,
+        0x8304104008054400ULL, 0x1000AC5003A45026ULL, 0x0202402080100508ULL, 0xC801042008040100ULL,
+        0x00400020210A0080ULL, 0x4010404200004104ULL, 0x0401180120008C00ULL, 0x0811450200110052ULL,
+        0xB10110825000A020ULL, 0x8104008405001050ULL, 0x0908094050030803ULL, 0x000414C204800804ULL,
+        0x2000202414004042ULL, 0x044001040020A100ULL, 0x0008100400440082ULL, 0x210101050A040102ULL,
+        0x8004442420080000ULL, 0x0906008421080000ULL, 0x0220208048081004ULL, 0x0000004084240800ULL,
+        0x00080020A0864200ULL, 0x40010484880E0000ULL, 0x9040100440808008ULL, 0x0010028089020002ULL,
+        0x100082004202C000ULL, 0x4049051042022000ULL, 0x010100010C110400ULL, 0x8200000B02208810ULL,
+        0x0000001008210100ULL, 0x0000180410241840ULL, 0x0880100401680A01ULL, 0x04021A0809040081ULL,
+    };
+
+    // Directions [B, F, L, R] for rooks and [BL, FR, BR, FL] for bishops
+    constexpr int ROOK_DIRECTIONS[4] = { B, F, L, R };
+    constexpr int BISHOP_DIRECTIONS[4] = { BL, FR, BR, FL };
+
+    // Squares attacked along the directions from the square, stopping at (and including) the first occupied square on each ray
+    constexpr std::uint64_t slidingAttacks(int square, std::uint64_t occupied, const int (&directions)[4])
+    {
+        std::uint64_t attacks = 0;
+        for (int d : directions) {
+            std::uint64_t ray = bitboards::RAYS[d][square];
+            std::uint64_t blockers = ray & occupied;
+            if (blockers) {
+                if (d % 2) {
+                    // Ray goes up the board, so the nearest blocker is the lowest one
+                    std::uint64_t nearest = blockers & (0 - blockers);
+                    ray &= (nearest << 1) - 1;
+                } else {
+                    // Ray goes down the board, so the nearest blocker is the highest one
+                    for (int shift = 1; shift < 64; shift <<= 1) {
+                        blockers |= blockers >> shift;
+                    }
+                    std::uint64_t nearest = blockers ^ (blockers >> 1);
+                    ray &= ~(nearest - 1);
+                }
+            }
+            attacks |= ray;
+        }
+        return attacks;
+    }
+
+    // Squares whose occupancy affects the attacks from the square (the last square of every ray is left out)
+    constexpr std::uint64_t occupancyMask(int square, const int (&directions)[4])
+    {
+        std::uint64_t mask = 0;
+        for (int d : directions) {
+            int fileOffset = bitboards::detail::DIRECTION_FILE_OFFSETS[d];
+            int rankOffset = bitboards::detail::DIRECTION_RANK_OFFSETS[d];
+            int file = square % 8 + fileOffset;
+            int rank = square / 8 + rankOffset;
+            while (onBoard(file + fileOffset, rank + rankOffset)) {
+                mask |= 1ULL << (rank * 8 + file);
+                file += fileOffset;
+                rank += rankOffset;
+            }
+        }
+        return mask;
+    }
+
+    constexpr int popcount(std::uint64_t bb)
+    {
+        int count = 0;
+        for (; bb; bb &= bb - 1) {
+            ++count;
+        }
+        return count;
+    }
+
+    constexpr std::array<Magic, 64> generateMagics(const std::uint64_t (&magicNumbers)[64], const int (&directions)[4])
+    {
+        std::array<Magic, 64> magics{};
+        std::uint32_t offset = 0;
+        for (int s = 0; s < 64; ++s) {
+            magics[s].mask = occupancyMask(s, directions);
+            magics[s].magic = magicNumbers[s];
+            magics[s].offset = offset;
+            magics[s].shift = 64 - popcount(magics[s].mask);
+            offset += 1U << popcount(magics[s].mask);
+        }
+        return magics;
+    }
+
+    template <std::size_t SIZE>
+    ATTACK_TABLE_CONSTEXPR std::array<std::uint64_t, SIZE> generateAttackTable(const std::array<Magic, 64>& magics, const int (&directions)[4])
+    {
+        std::array<std::uint64_t, SIZE> table{};
+        for (int s = 0; s < 64; ++s) {
+            // Enumerate every subset of the mask (carry-rippler)
+            std::uint64_t occupied = 0;
+            do {
+                std::uint64_t& entry = table[magics[s].offset + ((occupied * magics[s].magic) >> magics[s].shift)];
+                std::uint64_t attacks = slidingAttacks(s, occupied, directions);
+                // Attacks are never empty, so a set entry was already written by another occupancy of the square
+                // Sharing the entry is only safe if both occupancies have the same attacks
+                if (entry && entry != attacks) {
+                    throw std::logic_error("Destructive magic collision in slider attack table!");
+                }
+                entry = attacks;
+                occupied = (occupied - magics[s].mask) & magics[s].mask;
+            } while (occupied);
+        }
+        return table;
+    }
+
+    template <std::size_t SIZE>
+    ATTACK_TABLE_CONSTEXPR std::array<std::uint64_t, SIZE> generatePextAttackTable(const std::array<Magic, 64>& magics, const int (&directions)[4])
+    {
+        std::array<std::uint64_t, SIZE> table{};
+        for (int s = 0; s < 64; ++s) {
+            // The carry-rippler counts through the subsets in the same order as their pext index
+            std::uint64_t occupied = 0;
+            std::uint32_t index = 0;
+            do {
+                table[magics[s].offset + index++] = slidingAttacks(s, occupied, directions);
+                occupied = (occupied - magics[s].mask) & magics[s].mask;
+            } while (occupied);
+        }
+        return table;
+    }
+
+    void cpuid(std::uint32_t leaf, std::uint32_t (&registers)[4])
+    {
+#if defined(_MSC_VER) && defined(BITBOARDS_X64)
+        int out[4];
+        __cpuidex(out, static_cast<int>(leaf), 0);
+        for (int i = 0; i < 4; ++i) {
+            registers[i] = static_cast<std::uint32_t>(out[i]);
+        }
+#elif defined(BITBOARDS_X64)
+        __cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#else
+        (void)leaf;
+        registers[0] = registers[1] = registers[2] = registers[3] = 0;
+#endif
+    }
+
+    bitboards::SliderBackend detectSliderBackend()
+    {
+        // registers [eax, ebx, ecx, edx]
+        std::uint32_t registers[4];
+        cpuid(0, registers);
+        std::uint32_t maxLeaf = registers[0];
+        bool amd = registers[1] == 0x68747541; // "Auth" of "AuthenticAMD"
+
+        if (maxLeaf < 7) {
+            return bitboards::SliderBackend::MAGIC;
+        }
+
+        // BMI2 is leaf 7 ebx bit 8
+        cpuid(7, registers);
+        if (!(registers[1] & (1U << 8))) {
+            return bitboards::SliderBackend::MAGIC;
+        }
+
+        if (amd) {
+            // pext is microcoded (very slow) on AMD before Zen 3 (family 0x19)
+            cpuid(1, registers);
+            std::uint32_t family = (registers[0] >> 8) & 0xF;
+            if (family == 0xF) {
+                family += (registers[0] >> 20) & 0xFF;
+            }
+            if (family < 0x19) {
+                return bitboards::SliderBackend::MAGIC;
+            }
+        }
+
+        return bitboards::SliderBackend::PEXT;
+    }
+}
+
+namespace bitboards
+{
+    constexpr std::array<Magic, 64> ROOK_MAGICS = generateMagics(ROOK_MAGIC_NUMBERS, ROOK_DIRECTIONS);
+
+    constexpr std::array<Magic, 64> BISHOP_MAGICS = generateMagics(BISHOP_MAGIC_NUMBERS, BISHOP_DIRECTIONS);
+
+    ATTACK_TABLE_CONSTEXPR const std::array<std::uint64_t, ROOK_ATTACK_TABLE_SIZE> ROOK_ATTACK_TABLE = generateAttackTable<ROOK_ATTACK_TABLE_SIZE>(ROOK_MAGICS, ROOK_DIRECTIONS);
+
+    ATTACK_TABLE_CONSTEXPR const std::array<std::uint64_t, BISHOP_ATTACK_TABLE_SIZE> BISHOP_ATTACK_TABLE = generateAttackTable<BISHOP_ATTACK_TABLE_SIZE>(BISHOP_MAGICS, BISHOP_DIRECTIONS);
+
+    ATTACK_TABLE_CONSTEXPR const std::array<std::uint64_t, ROOK_ATTACK_TABLE_SIZE> ROOK_PEXT_ATTACK_TABLE = generatePextAttackTable<ROOK_ATTACK_TABLE_SIZE>(ROOK_MAGICS, ROOK_DIRECTIONS);
+
+    ATTACK_TABLE_CONSTEXPR const std::array<std::uint64_t, BISHOP_ATTACK_TABLE_SIZE> BISHOP_PEXT_ATTACK_TABLE = generatePextAttackTable<BISHOP_ATTACK_TABLE_SIZE>(BISHOP_MAGICS, BISHOP_DIRECTIONS);
+
+    const SliderBackend SLIDER_BACKEND = detectSliderBackend();
+
+    const char* sliderBackendName() noexcept
+    {
+        return SLIDER_BACKEND == SliderBackend::PEXT ? "pext" : "magic";
+    }
+
+    // The tables are laid out back to back, so the last square must end exactly at the table size
+    static_assert(ROOK_MAGICS[63].offset + (1U << (64 - ROOK_MAGICS[63].shift)) == ROOK_ATTACK_TABLE_SIZE, "Rook attack table size mismatch");
+    static_assert(BISHOP_MAGICS[63].offset + (1U << (64 - BISHOP_MAGICS[63].shift)) == BISHOP_ATTACK_TABLE_SIZE, "Bishop attack table size mismatch");
+}
@@ -0,0 +1,319 @@
+#pragma once
+#include <cstdint>
+#include <array>
+
+#include "precomputed_chess_data.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BITBOARDS_X64
+#endif
+
+/**
+ * Bitboard helpers and attack tables
+ * Bit i of a bitboard represents the square i [0, 63] -> [a1, h8]
+ */
+namespace bitboards
+{
+    constexpr std::uint64_t FILE_A = 0x0101010101010101ULL;
+    constexpr std::uint64_t FILE_H = FILE_A << 7;
+    constexpr std::uint64_t RANK_1 = 0xFFULL;
+    constexpr std::uint64_t RANK_3 = RANK_1 << 16;
+    constexpr std::uint64_t RANK_6 = RANK_1 << 40;
+    constexpr std::uint64_t RANK_8 = RANK_1 << 56;
+
+    /**
+     * @return bitboard with only the given square set
+     */
+    constexpr std::uint64_t bit(int square) noexcept
+    {
+        return 1ULL << square;
+    }
+
+    /**
+     * @return number of squares set in the bitboard
+     */
+    inline int popcount(std::uint64_t bb) noexcept
+    {
+#ifdef _MSC_VER
+        return static_cast<int>(__popcnt64(bb));
+#else
+        return __builtin_popcountll(bb);
+#endif
+    }
+
+    /**
+     * @return index of the lowest square set in the bitboard (bitboard must not be empty)
+     */
+    inline int lsb(std::uint64_t bb) noexcept
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bb);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bb);
+#endif
+    }
+
+    /**
+     * @return index of the highest square set in the bitboard (bitboard must not be empty)
+     */
+    inline int msb(std::uint64_t bb) noexcept
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, bb);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(bb);
+#endif
+    }
+
+    /**
+     * Parallel bit extract of the bits of src selected by mask (BMI2 pext)
+     * Must only be called when the cpu supports BMI2 (see SLIDER_BACKEND)
+     */
+    inline std::uint64_t pext(std::uint64_t src, std::uint64_t mask) noexcept
+    {
+#if defined(_MSC_VER) && defined(BITBOARDS_X64)
+        return _pext_u64(src, mask);
+#elif defined(BITBOARDS_X64)
+        // Inline asm so that the rest of the program does not have to be compiled for BMI2
+        std::uint64_t result;
+        __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(src), "r"(mask));
+        return result;
+#else
+        // Never selected on other architectures
+        (void)src;
+        (void)mask;
+        return 0;
+#endif
+    }
+
+    /**
+     * Removes the lowest square from the bitboard
+     * @return index of the removed square (bitboard must not be empty)
+     */
+    inline int popLsb(std::uint64_t& bb) noexcept
+    {
+        int square = lsb(bb);
+        bb &= bb - 1;
+        return square;
+    }
+
+    // TABLE GENERATION
+    namespace detail
+    {
+        // File and rank offsets for the 8 directions, ordered the same as DIRECTION_BOUNDS [-8, 8, -1, 1, -9, 9, -7, 7]
+        constexpr int DIRECTION_FILE_OFFSETS[8] = { 0, 0, -1, 1, -1, 1, 1, -1 };
+        constexpr int DIRECTION_RANK_OFFSETS[8] = { -1, 1, 0, 0, -1, 1, -1, 1 };
+
+        constexpr bool onBoard(int file, int rank)
+        {
+            return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+        }
+
+        constexpr std::array<std::uint64_t, 64> generateLeaperAttacks(const int (&fileOffsets)[8], const int (&rankOffsets)[8])
+        {
+            std::array<std::uint64_t, 64> table{};
+            for (int s = 0; s < 64; ++s) {
+                for (int j = 0; j < 8; ++j) {
+                    int file = s % 8 + fileOffsets[j];
+                    int rank = s / 8 + rankOffsets[j];
+                    if (onBoard(file, rank)) {
+                        table[s] |= 1ULL << (rank * 8 + file);
+                    }
+                }
+            }
+            return table;
+        }
+
+        constexpr int KNIGHT_FILE_OFFSETS[8] = { 1, 2, 2, 1, -1, -2, -2, -1 };
+        constexpr int KNIGHT_RANK_OFFSETS[8] = { 2, 1, -1, -2, -2, -1, 1, 2 };
+
+        constexpr std::array<std::array<std::uint64_t, 64>, 2> generatePawnAttacks()
+        {
+            std::array<std::array<std::uint64_t, 64>, 2> table{};
+            for (int c = 0; c < 2; ++c) {
+                int rankOffset = 1 - 2 * c;
+                for (int s = 0; s < 64; ++s) {
+                    int rank = s / 8 + rankOffset;
+                    if (onBoard(s % 8 - 1, rank)) {
+                        table[c][s] |= 1ULL << (rank * 8 + s % 8 - 1);
+                    }
+                    if (onBoard(s % 8 + 1, rank)) {
+                        table[c][s] |= 1ULL << (rank * 8 + s % 8 + 1);
+                    }
+                }
+            }
+            return table;
+        }
+
+        constexpr std::array<std::array<std::uint64_t, 64>, 8> generateRays()
+        {
+            std::array<std::array<std::uint64_t, 64>, 8> table{};
+            for (int d = 0; d < 8; ++d) {
+                for (int s = 0; s < 64; ++s) {
+                    int file = s % 8 + DIRECTION_FILE_OFFSETS[d];
+                    int rank = s / 8 + DIRECTION_RANK_OFFSETS[d];
+                    while (onBoard(file, rank)) {
+                        table[d][s] |= 1ULL << (rank * 8 + file);
+                        file += DIRECTION_FILE_OFFSETS[d];
+                        rank += DIRECTION_RANK_OFFSETS[d];
+                    }
+                }
+            }
+            return table;
+        }
+    }
+
+    // ATTACK TABLES
+    /**
+     * Squares attacked by a knight on every square [0, 63] -> [a1, h8]
+     */
+    inline constexpr std::array<std::uint64_t, 64> KNIGHT_ATTACKS = detail::generateLeaperAttacks(detail::KNIGHT_FILE_OFFSETS, detail::KNIGHT_RANK_OFFSETS);
+
+    /**
+     * Squares attacked by a king on every square [0, 63] -> [a1, h8]
+     */
+    inline constexpr std::array<std::uint64_t, 64> KING_ATTACKS = detail::generateLeaperAttacks(detail::DIRECTION_FILE_OFFSETS, detail::DIRECTION_RANK_OFFSETS);
+
+    /**
+     * Squares attacked by a white or black pawn (index 0 and 1) on every square [0, 63] -> [a1, h8]
+     */
+    inline constexpr std::array<std::array<std::uint64_t, 64>, 2> PAWN_ATTACKS = detail::generatePawnAttacks();
+
+    /**
+     * Squares on an empty board in every direction [B, F, L, R, BL, FR, BR, FL] from every square (not including the square itself)
+     */
+    inline constexpr std::array<std::array<std::uint64_t, 64>, 8> RAYS = detail::generateRays();
+
+    namespace detail
+    {
+        constexpr std::array<std::array<std::uint64_t, 64>, 64> generateBetween()
+        {
+            std::array<std::array<std::uint64_t, 64>, 64> table{};
+            for (int a = 0; a < 64; ++a) {
+                for (int b = 0; b < 64; ++b) {
+                    for (int d = 0; d < 8; ++d) {
+                        if (RAYS[d][a] & (1ULL << b)) {
+                            table[a][b] = RAYS[d][a] & ~(RAYS[d][b] | (1ULL << b));
+                        }
+                    }
+                }
+            }
+            return table;
+        }
+
+        constexpr std::array<std::array<std::uint64_t, 64>, 64> generateLine()
+        {
+            std::array<std::array<std::uint64_t, 64>, 64> table{};
+            for (int a = 0; a < 64; ++a) {
+                for (int d = 0; d < 8; ++d) {
+                    // Opposite directions are adjacent in [B, F, L, R, BL, FR, BR, FL]
+                    std::uint64_t line = RAYS[d][a] | RAYS[d ^ 1][a] | (1ULL << a);
+                    std::uint64_t ray = RAYS[d][a];
+                    while (ray) {
+                        int b = 0;
+                        while (!(ray & (1ULL << b))) {
+                            ++b;
+                        }
+                        table[a][b] = line;
+                        ray &= ray - 1;
+                    }
+                }
+            }
+            return table;
+        }
+    }
+
+    /**
+     * Squares strictly between two squares if they share a rank, file or diagonal (empty otherwise)
+     */
+    inline constexpr std::array<std::array<std::uint64_t, 64>, 64> BETWEEN = detail::generateBetween();
+
+    /**
+     * Every square of the full rank, file or diagonal through two squares, edge to edge (empty if they are not aligned)
+     * A peice pinned to its king on square a can only move to squares on LINE[a][peice square]
+     */
+    inline constexpr std::array<std::array<std::uint64_t, 64>, 64> LINE = detail::generateLine();
+
+    // SLIDING ATTACKS
+    /**
+     * Magic bitboard lookup data for a single square
+     * The attack table index is ((occupied & mask) * magic) >> shift, offset into the shared table
+     */
+    struct Magic
+    {
+        // Squares whose occupancy affects the attacks (edges of the rays are excluded)
+        std::uint64_t mask;
+
+        std::uint64_t magic;
+
+        std::uint32_t offset;
+
+        std::uint32_t shift;
+    };
+
+    constexpr int ROOK_ATTACK_TABLE_SIZE = 102400;
+    constexpr int BISHOP_ATTACK_TABLE_SIZE = 5248;
+
+    // Defined in bitboards.cpp (generated at compile time, or at startup by compilers other than MSVC)
+    extern const std::array<Magic, 64> ROOK_MAGICS;
+    extern const std::array<Magic, 64> BISHOP_MAGICS;
+    extern const std::array<std::uint64_t, ROOK_ATTACK_TABLE_SIZE> ROOK_ATTACK_TABLE;
+    extern const std::array<std::uint64_t, BISHOP_ATTACK_TABLE_SIZE> BISHOP_ATTACK_TABLE;
+
+    // Same layout as the magic tables, but indexed by pext(occupied, mask) instead of the magic multiplication
+    extern const std::array<std::uint64_t, ROOK_ATTACK_TABLE_SIZE> ROOK_PEXT_ATTACK_TABLE;
+    extern const std::array<std::uint64_t, BISHOP_ATTACK_TABLE_SIZE> BISHOP_PEXT_ATTACK_TABLE;
+
+    /**
+     * Implementation used for the sliding attack lookups
+     */
+    enum class SliderBackend
+    {
+        MAGIC,
+        PEXT
+    };
+
+    /**
+     * Chosen once at startup from cpuid
+     * PEXT is used when BMI2 is supported and pext is not microcoded (AMD before Zen 3), MAGIC otherwise
+     */
+    extern const SliderBackend SLIDER_BACKEND;
+
+    /**
+     * @return name of the sliding attack implementation in use
+     */
+    const char* sliderBackendName() noexcept;
+
+    /**
+     * @return squares attacked by a rook on the given square
+     */
+    inline std::uint64_t rookAttacks(int square, std::uint64_t occupied) noexcept
+    {
+        const Magic& m = ROOK_MAGICS[square];
+        if (SLIDER_BACKEND == SliderBackend::PEXT) {
+            return ROOK_PEXT_ATTACK_TABLE[m.offset + pext(occupied, m.mask)];
+        }
+        return ROOK_ATTACK_TABLE[m.offset + (((occupied & m.mask) * m.magic) >> m.shift)];
+    }
+
+    /**
+     * @return squares attacked by a bishop on the given square
+     */
+    inline std::uint64_t bishopAttacks(int square, std::uint64_t occupied) noexcept
+    {
+        const Magic& m = BISHOP_MAGICS[square];
+        if (SLIDER_BACKEND == SliderBackend::PEXT) {
+            return BISHOP_PEXT_ATTACK_TABLE[m.offset + pext(occupied, m.mask)];
+        }
+        return BISHOP_ATTACK_TABLE[m.offset + (((occupied & m.mask) * m.magic) >> m.shift)];
+    }
+}
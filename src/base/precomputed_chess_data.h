@@ -415,4 +415,10 @@ const std::uint_fast64_t ZOBRIST_KINGSIDE_CASTLING_KEYS[2] = { 53620525602241767
 /**
  * Random 64 bit keys for denoting queenside castling rights
  */
-const std::uint_fast64_t ZOBRIST_QUEENSIDE_CASTLING_KEYS[2] = { 12085591603708853699ULL, 17859103354573023985ULL };
\ No newline at end of file
+const std::uint_fast64_t ZOBRIST_QUEENSIDE_CASTLING_KEYS[2] = { 12085591603708853699ULL, 17859103354573023985ULL };
+
+/**
+ * Random 64 bit keys for denoting the file of the en passant square
+ * Not part of the engine zobrist hashes, used where positions that only differ by en passant have to be told apart (perft table)
+ */
+const std::uint_fast64_t ZOBRIST_EN_PASSANT_KEYS[8] = { 11748679535743047394ULL, 6733210580368162789ULL, 12625370704421527439ULL, 12112320960618481551ULL, 4851356601251894085ULL, 11110146462374650555ULL, 18390008073019070218ULL, 16958515624929043147ULL };
\ No newline at end of file
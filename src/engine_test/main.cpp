@@ -1,6 +1,12 @@
 #include <iostream>
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <chrono>
 
-//#include "perft.h"
+#include "perft.h"
+#include "shard.h"
 #include "EngineV1_3.h"
 #include "StandardMove.h"
 //#include "Game.h"
@@ -9,8 +15,73 @@
 using namespace std;
 //using namespace std::chrono_literals;
 
-int main()
+int main(int argc, char** argv)
 {
+	// engine_test suite <report.json|report.csv> [threads]
+	// Runs the accuracy suite in parallel, writes a report and exits with 1 if any entry did not match
+	if (argc > 2 && string(argv[1]) == "suite") {
+		unsigned threads = argc > 3 ? stoi(argv[3]) : thread::hardware_concurrency();
+		return perft::runAccuracySuite([]() {
+			auto engine = make_unique<EngineV1_3>();
+			// The suite entries are already spread over the threads
+			engine->setPerftThreads(1);
+			return unique_ptr<PerftTestableEngine>(move(engine));
+		}, "v1.3", threads, argv[2]);
+	}
+
+	// engine_test shard split <queue dir> <depth> <split depth> <fen>
+	// engine_test shard work <queue dir> [threads] [hash MB]
+	// engine_test shard resume <queue dir>
+	// engine_test shard collect <queue dir>
+	// Perft split into jobs in a queue directory, which any number of worker processes can run (see shard.h)
+	if (argc > 3 && string(argv[1]) == "shard") {
+		string command = argv[2];
+		EngineV1_3 engine;
+		if (command == "split" && argc > 6) {
+			string fen = argv[6];
+			for (int i = 7; i < argc; ++i) {
+				fen += string(" ") + argv[i];
+			}
+			shard::split(engine, fen, stoi(argv[4]), stoi(argv[5]), argv[3]);
+			return 0;
+		}
+		if (command == "work") {
+			engine.setPerftThreads(argc > 4 ? stoi(argv[4]) : thread::hardware_concurrency());
+			engine.setPerftHash(argc > 5 ? stoi(argv[5]) : 0);
+			shard::work(engine, argv[3]);
+			return 0;
+		}
+		if (command == "resume") {
+			shard::resume(argv[3]);
+			return 0;
+		}
+		if (command == "collect") {
+			return shard::collect(argv[3]) ? 0 : 1;
+		}
+		cerr << "unknown shard command " << command << endl;
+		return 1;
+	}
+
+	// engine_test smp <depth> <positions> <think millis> <games>
+	// Time to depth and Elo at a fixed time per move of the lazy SMP search with 1, 2, 4, 8 and 16 threads
+	if (argc > 5 && string(argv[1]) == "smp") {
+		auto makeEngine = [](unsigned threads) {
+			auto engine = make_unique<EngineV1_3>();
+			engine->setSearchThreads(threads);
+			return unique_ptr<PerftTestableEngine>(move(engine));
+		};
+		vector<unsigned> threadCounts = { 1, 2, 4, 8, 16 };
+		perft::testTimeToDepth(makeEngine, threadCounts, stoi(argv[2]), stoi(argv[3]));
+		perft::testThreadElo(makeEngine, threadCounts, chrono::milliseconds(stoi(argv[4])), stoi(argv[5]));
+		return 0;
+	}
+
+	// engine_test ttable
+	// Checks what the transposition table keeps when an entry is overwritten and exits with 1 if any check failed
+	if (argc > 1 && string(argv[1]) == "ttable") {
+		return perft::testTranspositionTable();
+	}
+
 	EngineV1_3 engine;
 
 	cout << "Starting posiiton: ";
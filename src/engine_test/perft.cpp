@@ -7,16 +7,132 @@
 #include <chrono>
 #include <stdexcept>
 #include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <thread>
+#include <sstream>
+#include <cmath>
+#include <optional>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 #include "jsoncpp/json/json.h"
 #include "StandardEngine.h"
+#include "bitboards.h"
+#include "TranspositionTable.h"
 
 // ANSI escape codes for text colors
 #define RED_TEXT "\033[31m"
 #define GREEN_TEXT "\033[32m"
 #define RESET_TEXT "\033[0m"
 
-void perft::testAccuracy(PerftTestableEngine& engine)
+// Counts every global heap allocation made by the test program so tests can report allocations made during a search
+static std::atomic<std::uint64_t> heapAllocations(0);
+
+void* operator new(std::size_t size)
+{
+    ++heapAllocations;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+// Over-aligned types (like the engines) are allocated through these, and must be freed with the matching aligned function
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++heapAllocations;
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(size ? size : 1, align);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, align, size ? size : 1)) {
+        ptr = nullptr;
+    }
+#endif
+    if (ptr) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+// Entry of the accuracy test suite
+struct AccuracyTest
+{
+    int depth;
+    std::uint64_t nodes;
+    std::string fen;
+};
+
+// Result of an accuracy test run by runAccuracySuite
+struct AccuracyResult
+{
+    std::uint64_t nodes;
+    std::chrono::nanoseconds time;
+};
+
+// Reads the entries of accuracy_test_suite.json
+static std::vector<AccuracyTest> loadAccuracySuite()
 {
     // Open the JSON file
     std::ifstream file("accuracy_test_suite.json");
@@ -43,20 +159,68 @@ void perft::testAccuracy(PerftTestableEngine& engine)
         throw std::runtime_error("Root is not an array!");
     }
 
-    std::cout << "PERFT SUITE" << std::endl;
-    auto startTotal = std::chrono::high_resolution_clock::now();
-
-    // Loop over array elements
+    std::vector<AccuracyTest> tests;
     for (const auto& arrayElement : root) {
         // Check if each element is an object
         if (!arrayElement.isObject()) {
             throw std::runtime_error("Array element is not an object!");
         }
 
-        // Extract data from the object
-        int depth = arrayElement["depth"].asInt();
-        int nodes = arrayElement["nodes"].asInt();
-        std::string fen = arrayElement["fen"].asString();
+        tests.push_back({ arrayElement["depth"].asInt(), arrayElement["nodes"].asUInt64(), arrayElement["fen"].asString() });
+    }
+    return tests;
+}
+
+// Games longer than this are counted as draws
+static constexpr int MAX_GAME_PLIES = 300;
+
+// Plays a game between two engines from the given position
+// returns the result for white (1 win, 0.5 draw, 0 loss)
+static double playGame(StandardEngine& white, StandardEngine& black, const std::string& fen, std::chrono::milliseconds thinkTime)
+{
+    white.loadFEN(fen);
+    black.loadFEN(fen);
+
+    for (int ply = 0; ply < MAX_GAME_PLIES; ++ply) {
+        std::optional<int> result = white.gameOver();
+        if (result.has_value()) {
+            return (*result + 1) / 2.0;
+        }
+
+        StandardEngine& toMove = white.colorToMove() == 1 ? white : black;
+        StandardMove move = toMove.computerMove(thinkTime);
+        white.inputMove(move);
+        black.inputMove(move);
+    }
+    return 0.5;
+}
+
+// Escapes the quotes of a CSV field
+static std::string csvField(const std::string& field)
+{
+    std::string escaped = "\"";
+    for (char c : field) {
+        if (c == '"') {
+            escaped += '"';
+        }
+        escaped += c;
+    }
+    return escaped + '"';
+}
+
+void perft::testAccuracy(PerftTestableEngine& engine)
+{
+    std::vector<AccuracyTest> tests = loadAccuracySuite();
+
+    std::cout << "PERFT SUITE" << std::endl;
+    std::cout << "sliding attacks: " << bitboards::sliderBackendName() << std::endl;
+    std::uint64_t total = 0;
+    auto startTotal = std::chrono::high_resolution_clock::now();
+
+    for (const AccuracyTest& test : tests) {
+        int depth = test.depth;
+        std::uint64_t nodes = test.nodes;
+        const std::string& fen = test.fen;
 
         // Display test data
         engine.loadFEN(fen);
@@ -68,6 +232,7 @@ void perft::testAccuracy(PerftTestableEngine& engine)
         std::uint64_t out = engine.perft(depth);
         auto endPerft = std::chrono::high_resolution_clock::now();
         auto durationPerft = std::chrono::duration_cast<std::chrono::milliseconds>(endPerft - startPerft);
+        total += out;
 
         // Display test result
         if (out == nodes) {
@@ -82,6 +247,104 @@ void perft::testAccuracy(PerftTestableEngine& engine)
     auto endTotal = std::chrono::high_resolution_clock::now();
     auto durationTotal = std::chrono::duration_cast<std::chrono::milliseconds>(endTotal - startTotal);
     std::cout << "TOTAL TIME: " << durationTotal.count() << " millis" << std::endl;
+
+    std::cout << std::endl << "PERFT RATE (" << bitboards::sliderBackendName() << "): " << (1000 * total) / std::max<std::int64_t>(durationTotal.count(), 1) << " nodes/s" << std::endl;
+}
+
+int perft::runAccuracySuite(const std::function<std::unique_ptr<PerftTestableEngine>()>& makeEngine, const std::string& engineName, unsigned threads, const std::string& reportPath)
+{
+    std::vector<AccuracyTest> tests = loadAccuracySuite();
+    std::vector<AccuracyResult> results(tests.size());
+
+    threads = std::max(1U, std::min(threads, static_cast<unsigned>(tests.size())));
+    std::cout << "PERFT SUITE (" << engineName << ", " << threads << " threads)" << std::endl;
+    std::cout << "sliding attacks: " << bitboards::sliderBackendName() << std::endl;
+    auto startTotal = std::chrono::high_resolution_clock::now();
+
+    // Every thread takes the next entry that has not been started
+    std::atomic<size_t> nextTest(0);
+    auto worker = [&]() {
+        std::unique_ptr<PerftTestableEngine> engine = makeEngine();
+        for (size_t i = nextTest++; i < tests.size(); i = nextTest++) {
+            engine->loadFEN(tests[i].fen);
+            auto startPerft = std::chrono::high_resolution_clock::now();
+            results[i].nodes = engine->perft(tests[i].depth);
+            results[i].time = std::chrono::high_resolution_clock::now() - startPerft;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    auto endTotal = std::chrono::high_resolution_clock::now();
+    auto durationTotal = std::chrono::duration_cast<std::chrono::milliseconds>(endTotal - startTotal);
+
+    // Display the results in suite order
+    std::uint64_t total = 0;
+    int failures = 0;
+    Json::Value report(Json::objectValue);
+    report["engine"] = engineName;
+    report["threads"] = threads;
+    report["tests"] = Json::Value(Json::arrayValue);
+    std::ostringstream csv;
+    csv << "engine,fen,depth,expected,nodes,millis,nps,result\n";
+
+    for (size_t i = 0; i < tests.size(); ++i) {
+        const AccuracyTest& test = tests[i];
+        const AccuracyResult& result = results[i];
+        bool success = result.nodes == test.nodes;
+        double millis = std::chrono::duration<double, std::milli>(result.time).count();
+        std::uint64_t nps = static_cast<std::uint64_t>(result.nodes * 1e9 / std::max<std::int64_t>(result.time.count(), 1));
+        total += result.nodes;
+        failures += !success;
+
+        std::cout << "depth " << test.depth << " fen " << test.fen << std::endl;
+        std::cout << "result: " << (success ? GREEN_TEXT : RED_TEXT) << result.nodes << RESET_TEXT << (success ? " SUCCESS" : " FAIL");
+        std::cout << " time: " << millis << " millis" << std::endl;
+
+        Json::Value entry(Json::objectValue);
+        entry["fen"] = test.fen;
+        entry["depth"] = test.depth;
+        entry["expected"] = Json::UInt64(test.nodes);
+        entry["nodes"] = Json::UInt64(result.nodes);
+        entry["millis"] = millis;
+        entry["nps"] = Json::UInt64(nps);
+        entry["result"] = success ? "SUCCESS" : "FAIL";
+        report["tests"].append(entry);
+
+        csv << csvField(engineName) << ',' << csvField(test.fen) << ',' << test.depth << ',' << test.nodes << ',' << result.nodes << ','
+            << millis << ',' << nps << ',' << (success ? "SUCCESS" : "FAIL") << '\n';
+    }
+
+    std::uint64_t totalNps = (1000 * total) / std::max<std::int64_t>(durationTotal.count(), 1);
+    report["totalNodes"] = Json::UInt64(total);
+    report["totalMillis"] = Json::Int64(durationTotal.count());
+    report["nps"] = Json::UInt64(totalNps);
+    report["failures"] = failures;
+
+    std::cout << std::endl << "TOTAL TIME: " << durationTotal.count() << " millis" << std::endl;
+    std::cout << "PERFT RATE (" << bitboards::sliderBackendName() << "): " << totalNps << " nodes/s" << std::endl;
+    std::cout << (failures ? RED_TEXT : GREEN_TEXT) << failures << " FAILED" << RESET_TEXT << std::endl;
+
+    // Write the report
+    std::ofstream reportFile(reportPath);
+    if (!reportFile.is_open()) {
+        throw std::runtime_error("Error opening report file " + reportPath);
+    }
+    if (reportPath.size() >= 4 && reportPath.compare(reportPath.size() - 4, 4, ".csv") == 0) {
+        reportFile << csv.str();
+    }
+    else {
+        Json::StreamWriterBuilder writerBuilder;
+        reportFile << Json::writeString(writerBuilder, report) << std::endl;
+    }
+
+    return failures ? 1 : 0;
 }
 
 void perft::testSpeed(PerftTestableEngine& engine, int depth)
@@ -90,8 +353,12 @@ void perft::testSpeed(PerftTestableEngine& engine, int depth)
     std::ifstream file("preformace_test_suite.txt");
 
     std::cout << "PREFORMANCE TEST:" << std::endl;
+    std::cout << "sliding attacks: " << bitboards::sliderBackendName() << std::endl;
     auto startTotal = std::chrono::high_resolution_clock::now();
 
+    std::uint64_t total = 0;
+    std::uint64_t allocations = 0;
+
     std::string fen;
     while (std::getline(file, fen)) {
         // Display test data
@@ -100,10 +367,13 @@ void perft::testSpeed(PerftTestableEngine& engine, int depth)
         std::cout.flush();
 
         // Run test
+        std::uint64_t allocationsBefore = heapAllocations;
         auto startPerft = std::chrono::high_resolution_clock::now();
         std::uint64_t out = engine.perft(depth);
+        allocations += heapAllocations - allocationsBefore;
         auto endPerft = std::chrono::high_resolution_clock::now();
         auto durationPerft = std::chrono::duration_cast<std::chrono::milliseconds>(endPerft - startPerft);
+        total += out;
 
         // Display test result
         std::cout << " time " << durationPerft.count() << " millis" << std::endl;
@@ -111,7 +381,11 @@ void perft::testSpeed(PerftTestableEngine& engine, int depth)
 
     auto endTotal = std::chrono::high_resolution_clock::now();
     auto durationTotal = std::chrono::duration_cast<std::chrono::milliseconds>(endTotal - startTotal);
-    std::cout << std::endl << "TOTAL TIME: " << durationTotal.count() << " millis" << std::endl;
+    std::cout << std::endl << "TOTAL NODES: " << total << std::endl;
+    std::cout << "TOTAL TIME: " << durationTotal.count() << " millis" << std::endl;
+    std::cout << "HEAP ALLOCATIONS: " << allocations << std::endl;
+
+    std::cout << std::endl << "PERFT RATE (" << bitboards::sliderBackendName() << "): " << (1000 * total) / std::max<std::int64_t>(durationTotal.count(), 1) << " nodes/s" << std::endl;
 }
 
 void perft::testSearchEfficiency(PerftTestableEngine& engine, int depth, int numTests)
@@ -123,17 +397,23 @@ void perft::testSearchEfficiency(PerftTestableEngine& engine, int depth, int num
     auto startTotal = std::chrono::high_resolution_clock::now();
 
     std::uint64_t total = 0;
+    std::uint64_t allocations = 0;
+    int testsRun = 0;
 
     std::string fen;
     while (std::getline(file, fen)) {
         if (numTests-- <= 0) {
             break;
         }
+        ++testsRun;
+
         // Display test data
         engine.loadFEN(fen);
 
         // Run test
+        std::uint64_t allocationsBefore = heapAllocations;
         total += engine.search_perft(depth);
+        allocations += heapAllocations - allocationsBefore;
         std::cout.flush();
     }
 
@@ -145,6 +425,8 @@ void perft::testSearchEfficiency(PerftTestableEngine& engine, int depth, int num
     auto durationTotal = std::chrono::duration_cast<std::chrono::milliseconds>(endTotal - startTotal);
     std::cout << std::endl << "TOTAL NODES: " << total << std::endl;
     std::cout << "TOTAL TIME: " << durationTotal.count() << " millis" << std::endl;
+    // Allocations made outside of the search itself (root move sorting, printing) are constant per test, not per node
+    std::cout << "HEAP ALLOCATIONS: " << allocations << " (" << testsRun << " searches)" << std::endl;
 
     std::cout << std::endl << "SEARCH RATE: " << (1000 * total) / durationTotal.count() << " nodes/s" << std::endl;
 }
@@ -158,18 +440,23 @@ void perft::testSearchSpeed(PerftTestableEngine& engine, std::chrono::millisecon
     auto startTotal = std::chrono::high_resolution_clock::now();
 
     std::uint64_t total = 0;
+    std::uint64_t allocations = 0;
+    int testsRun = 0;
 
     std::string fen;
     while (std::getline(file, fen)) {
         if (numTests-- <= 0) {
             break;
         }
+        ++testsRun;
 
         // Display test data
         engine.loadFEN(fen);
 
         // Run test
+        std::uint64_t allocationsBefore = heapAllocations;
         total += engine.search_perft(thinkTime);
+        allocations += heapAllocations - allocationsBefore;
         std::cout.flush();
     }
 
@@ -181,6 +468,137 @@ void perft::testSearchSpeed(PerftTestableEngine& engine, std::chrono::millisecon
     auto durationTotal = std::chrono::duration_cast<std::chrono::milliseconds>(endTotal - startTotal);
     std::cout << std::endl << "TOTAL NODES: " << total << std::endl;
     std::cout << "TOTAL TIME: " << durationTotal.count() << " millis" << std::endl;
+    std::cout << "HEAP ALLOCATIONS: " << allocations << " (" << testsRun << " searches)" << std::endl;
 
     std::cout << std::endl << "SEARCH RATE: " << (1000 * total) / durationTotal.count() << " nodes/s" << std::endl;
 }
+
+void perft::testTimeToDepth(const std::function<std::unique_ptr<PerftTestableEngine>(unsigned threads)>& makeEngine, const std::vector<unsigned>& threadCounts, int depth, int numTests)
+{
+    std::cout << "TIME TO DEPTH TEST:" << std::endl;
+
+    std::vector<std::string> fens;
+    std::ifstream file("preformace_test_suite.txt");
+    std::string fen;
+    while (static_cast<int>(fens.size()) < numTests && std::getline(file, fen)) {
+        fens.push_back(fen);
+    }
+
+    std::int64_t baseTime = 0;
+    std::vector<std::string> summary;
+    for (unsigned threads : threadCounts) {
+        std::unique_ptr<PerftTestableEngine> engine = makeEngine(threads);
+
+        std::uint64_t nodes = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const std::string& position : fens) {
+            engine->loadFEN(position);
+            nodes += engine->search_perft(depth);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::int64_t time = std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(), 1);
+
+        if (!baseTime) {
+            baseTime = time;
+        }
+
+        std::ostringstream line;
+        line << std::setw(3) << threads << " threads: time " << time << " millis nodes " << nodes;
+        line << " speedup " << std::fixed << std::setprecision(2) << static_cast<double>(baseTime) / time;
+        summary.push_back(line.str());
+    }
+
+    std::cout << std::endl << "DEPTH " << depth << " OVER " << fens.size() << " POSITIONS:" << std::endl;
+    for (const std::string& line : summary) {
+        std::cout << line << std::endl;
+    }
+}
+
+void perft::testThreadElo(const std::function<std::unique_ptr<PerftTestableEngine>(unsigned threads)>& makeEngine, const std::vector<unsigned>& threadCounts, std::chrono::milliseconds thinkTime, int numGames)
+{
+    if (numGames <= 0) {
+        return;
+    }
+
+    std::cout << "THREAD ELO TEST:" << std::endl;
+
+    std::vector<std::string> fens;
+    std::ifstream file("preformace_test_suite.txt");
+    std::string fen;
+    while (static_cast<int>(fens.size()) < (numGames + 1) / 2 && std::getline(file, fen)) {
+        fens.push_back(fen);
+    }
+    if (fens.empty()) {
+        throw std::runtime_error("preformace_test_suite.txt has no positions");
+    }
+
+    std::vector<std::string> summary;
+    for (unsigned threads : threadCounts) {
+        std::unique_ptr<PerftTestableEngine> engine = makeEngine(threads);
+        std::unique_ptr<PerftTestableEngine> baseline = makeEngine(1);
+
+        // Every position is played once with each color
+        double score = 0;
+        for (int game = 0; game < numGames; ++game) {
+            const std::string& position = fens[(game / 2) % fens.size()];
+            if (game % 2) {
+                score += 1 - playGame(*baseline, *engine, position, thinkTime);
+            }
+            else {
+                score += playGame(*engine, *baseline, position, thinkTime);
+            }
+        }
+
+        // Elo difference from the expected score, clamped so that winning or losing every game is finite
+        double fraction = std::clamp(score / numGames, 0.01, 0.99);
+        double elo = 400 * std::log10(fraction / (1 - fraction));
+
+        std::ostringstream line;
+        line << std::setw(3) << threads << " threads: score " << score << "/" << numGames;
+        line << " elo " << std::showpos << std::fixed << std::setprecision(0) << elo;
+        summary.push_back(line.str());
+    }
+
+    std::cout << std::endl << "ELO AGAINST 1 THREAD AT " << thinkTime.count() << " MILLIS PER MOVE:" << std::endl;
+    for (const std::string& line : summary) {
+        std::cout << line << std::endl;
+    }
+}
+
+int perft::testTranspositionTable()
+{
+    using Entry = TranspositionTable::Entry;
+
+    std::cout << "TRANSPOSITION TABLE TEST" << std::endl;
+    int failures = 0;
+    auto check = [&failures](bool passed, const std::string& name) {
+        std::cout << name << ": " << (passed ? GREEN_TEXT "SUCCESS" : RED_TEXT "FAIL") << RESET_TEXT << std::endl;
+        failures += !passed;
+    };
+
+    TranspositionTable ttable(1);
+    std::uint64_t zobrist = 0x0123456789ABCDEFULL;
+    ttable.newSearch();
+
+    // Quiscence search stores the static eval without a move, search_std stores a move without a static eval
+    ttable.storeEntry(Entry(zobrist, 0, 40, Entry::EXACT_VALUE, 0, 25), zobrist);
+    ttable.storeEntry(Entry(zobrist, 3, 60, Entry::LOWER_BOUND, 0x0A1C), zobrist);
+    Entry entry = ttable.getEntry(zobrist);
+    check(entry.isHit(zobrist) && entry.depth() == 3 && entry.eval() == 60 && entry.move() == 0x0A1C && entry.staticEval() == 25,
+        "search_std store keeps the quiscence static eval");
+
+    // A shallower entry replaces it in a later search, still keeping the fields it does not have
+    ttable.newSearch();
+    ttable.storeEntry(Entry(zobrist, 1, -10, Entry::UPPER_BOUND, 0), zobrist);
+    entry = ttable.getEntry(zobrist);
+    check(entry.isHit(zobrist) && entry.depth() == 1 && entry.eval() == -10 && entry.move() == 0x0A1C && entry.staticEval() == 25,
+        "later search keeps the move and static eval");
+
+    // A new static eval replaces the old one
+    ttable.storeEntry(Entry(zobrist, 2, 5, Entry::EXACT_VALUE, 0, 30), zobrist);
+    entry = ttable.getEntry(zobrist);
+    check(entry.isHit(zobrist) && entry.staticEval() == 30, "new static eval replaces the old one");
+
+    std::cout << (failures ? RED_TEXT : GREEN_TEXT) << failures << " FAILED" << RESET_TEXT << std::endl;
+    return failures ? 1 : 0;
+}
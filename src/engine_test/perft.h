@@ -2,6 +2,10 @@
 
 #include <iostream>
 #include <chrono>
+#include <memory>
+#include <functional>
+#include <string>
+#include <vector>
 #include "PerftTestableEngine.h"
 
 namespace perft
@@ -16,7 +20,32 @@ namespace perft
     */
     void testSpeed(PerftTestableEngine& engine, int depth = 4);
 
+    /**
+     * Runs the accuracy suite with the entries spread over the given number of threads (one engine per thread from makeEngine)
+     * Writes the node count, time and nodes per second of every entry to reportPath (CSV if it ends in .csv, JSON otherwise)
+     * @return 0 if every entry matched, 1 otherwise (to be used as the exit code)
+    */
+    int runAccuracySuite(const std::function<std::unique_ptr<PerftTestableEngine>()>& makeEngine, const std::string& engineName, unsigned threads, const std::string& reportPath);
+
     void testSearchEfficiency(PerftTestableEngine& engine, int depth, int numTests);
 
     void testSearchSpeed(PerftTestableEngine& engine, std::chrono::milliseconds thinkTime, int numTests);
+
+    /**
+     * Measures the time a search to the given depth takes with every thread count (one engine per count from makeEngine)
+     * Prints the total time over the first numTests positions of the search suite and the speedup over the first count
+    */
+    void testTimeToDepth(const std::function<std::unique_ptr<PerftTestableEngine>(unsigned threads)>& makeEngine, const std::vector<unsigned>& threadCounts, int depth, int numTests);
+
+    /**
+     * Plays numGames games at a fixed time per move between an engine with each thread count and a 1 thread engine
+     * The games start from the positions of the search suite with colors alternating, and the Elo difference of every count is printed
+    */
+    void testThreadElo(const std::function<std::unique_ptr<PerftTestableEngine>(unsigned threads)>& makeEngine, const std::vector<unsigned>& threadCounts, std::chrono::milliseconds thinkTime, int numGames);
+
+    /**
+     * Checks what the transposition table keeps when an entry is overwritten by one of the same position
+     * @return 0 if every check passed, 1 otherwise (to be used as the exit code)
+    */
+    int testTranspositionTable();
 }
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "shard.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+
+#include "StandardMove.h"
+
+namespace fs = std::filesystem;
+
+// Reads the "key value" lines of a queue file
+static std::map<std::string, std::string> readQueueFile(const fs::path& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening queue file " + path.string());
+    }
+
+    std::map<std::string, std::string> values;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        if (space != std::string::npos) {
+            values[line.substr(0, space)] = line.substr(space + 1);
+        }
+    }
+    return values;
+}
+
+// Writes the file to a temporary path first, so the file either does not exist or is complete
+static void writeQueueFile(const fs::path& path, const std::string& contents)
+{
+    fs::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Error opening queue file " + temporary.string());
+        }
+        file << contents;
+        if (!file.flush()) {
+            throw std::runtime_error("Error writing queue file " + temporary.string());
+        }
+    }
+    fs::rename(temporary, path);
+}
+
+int shard::split(PerftTestableEngine& engine, const std::string& fen, int depth, int splitDepth, const std::string& queueDir)
+{
+    if (splitDepth < 1 || splitDepth > depth) {
+        throw std::invalid_argument("Split depth must be between 1 and the perft depth!");
+    }
+
+    fs::path queue(queueDir);
+    if (fs::exists(queue) && !fs::is_empty(queue)) {
+        throw std::runtime_error("Queue directory " + queueDir + " is not empty!");
+    }
+
+    // The queue is built in a temporary directory and renamed once it is complete, so a failed split never leaves a partial queue
+    fs::path temporary = queue;
+    temporary += ".tmp";
+    fs::remove_all(temporary);
+    fs::create_directories(temporary / "pending");
+    fs::create_directories(temporary / "running");
+    fs::create_directories(temporary / "done");
+
+    engine.loadFEN(fen);
+    std::vector<PerftTestableEngine::PerftSplit> splits = engine.perftSplit(splitDepth);
+
+    int numJobs = 0;
+    for (const PerftTestableEngine::PerftSplit& split : splits) {
+        std::ostringstream root;
+        root << split.rootMove;
+
+        std::ostringstream job;
+        job << "fen " << split.fen << "\n";
+        job << "depth " << depth - splitDepth << "\n";
+        job << "root " << root.str() << "\n";
+
+        std::ostringstream name;
+        name << std::setw(8) << std::setfill('0') << numJobs++;
+        writeQueueFile(temporary / "pending" / name.str(), job.str());
+    }
+
+    std::ostringstream shards;
+    shards << "fen " << fen << "\n";
+    shards << "depth " << depth << "\n";
+    shards << "split " << splitDepth << "\n";
+    shards << "jobs " << numJobs << "\n";
+    writeQueueFile(temporary / "shards.txt", shards.str());
+
+    fs::remove(queue);
+    fs::rename(temporary, queue);
+
+    std::cout << "SHARDS: " << numJobs << " jobs of depth " << depth - splitDepth << " in " << queueDir << std::endl;
+    return numJobs;
+}
+
+int shard::work(PerftTestableEngine& engine, const std::string& queueDir)
+{
+    fs::path queue(queueDir);
+    int jobsRun = 0;
+
+    for (bool claimed = true; claimed;) {
+        claimed = false;
+
+        for (const fs::directory_entry& entry : fs::directory_iterator(queue / "pending")) {
+            fs::path name = entry.path().filename();
+            if (name.extension() == ".tmp") {
+                continue;
+            }
+
+            // Only one worker can rename the job out of pending
+            std::error_code error;
+            fs::rename(entry.path(), queue / "running" / name, error);
+            if (error) {
+                continue;
+            }
+            claimed = true;
+
+            std::map<std::string, std::string> job = readQueueFile(queue / "running" / name);
+            std::cout << "job " << name.string() << " fen " << job["fen"] << " depth " << job["depth"];
+            std::cout.flush();
+
+            engine.loadFEN(job["fen"]);
+            auto start = std::chrono::high_resolution_clock::now();
+            std::uint64_t nodes = engine.perft(std::stoi(job["depth"]));
+            auto end = std::chrono::high_resolution_clock::now();
+
+            std::ostringstream done;
+            done << "fen " << job["fen"] << "\n";
+            done << "depth " << job["depth"] << "\n";
+            done << "root " << job["root"] << "\n";
+            done << "nodes " << nodes << "\n";
+            writeQueueFile(queue / "done" / name, done.str());
+            fs::remove(queue / "running" / name);
+            ++jobsRun;
+
+            std::cout << " nodes " << nodes << " time " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " millis" << std::endl;
+
+            // Start again from the first pending job, the directory may have changed while the job ran
+            break;
+        }
+    }
+
+    std::cout << "WORKER DONE: " << jobsRun << " jobs" << std::endl;
+    return jobsRun;
+}
+
+int shard::resume(const std::string& queueDir)
+{
+    fs::path queue(queueDir);
+    int requeued = 0;
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(queue / "running")) {
+        fs::path name = entry.path().filename();
+
+        // The worker may have crashed after writing its result but before removing the claimed job
+        if (fs::exists(queue / "done" / name)) {
+            fs::remove(entry.path());
+        }
+        else {
+            fs::rename(entry.path(), queue / "pending" / name);
+            ++requeued;
+        }
+    }
+
+    std::cout << "RESUMED: " << requeued << " jobs put back in pending" << std::endl;
+    return requeued;
+}
+
+bool shard::collect(const std::string& queueDir)
+{
+    fs::path queue(queueDir);
+    std::map<std::string, std::string> shards = readQueueFile(queue / "shards.txt");
+    int numJobs = std::stoi(shards["jobs"]);
+
+    // Node counts of the root moves in the order they are first seen
+    std::vector<std::string> rootMoves;
+    std::map<std::string, std::uint64_t> rootNodes;
+    std::uint64_t nodes = 0;
+    int jobsDone = 0;
+
+    // Job names are numbered in move generation order
+    std::vector<fs::path> donePaths;
+    for (const fs::directory_entry& entry : fs::directory_iterator(queue / "done")) {
+        if (entry.path().extension() != ".tmp") {
+            donePaths.push_back(entry.path());
+        }
+    }
+    std::sort(donePaths.begin(), donePaths.end());
+
+    for (const fs::path& path : donePaths) {
+        std::map<std::string, std::string> job = readQueueFile(path);
+        std::uint64_t jobNodes = std::stoull(job["nodes"]);
+        if (!rootNodes.count(job["root"])) {
+            rootMoves.push_back(job["root"]);
+        }
+        rootNodes[job["root"]] += jobNodes;
+        nodes += jobNodes;
+        ++jobsDone;
+    }
+
+    std::cout << "PERFT SHARDS\nFEN: " << shards["fen"] << "\nDEPTH: " << shards["depth"] << std::endl;
+    for (size_t i = 0; i < rootMoves.size(); ++i) {
+        std::cout << std::setw(2) << i << " *** " << rootMoves[i] << ": " << rootNodes[rootMoves[i]] << std::endl;
+    }
+    std::cout << "JOBS DONE: " << jobsDone << "/" << numJobs << std::endl;
+    std::cout << (jobsDone == numJobs ? "TOTAL: " : "PARTIAL TOTAL: ") << nodes << std::endl;
+    return jobsDone == numJobs;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include "PerftTestableEngine.h"
+
+/**
+ * Perft split into subtree jobs that are run by any number of worker processes
+ * The jobs are files in a queue directory, so workers only need access to the directory (it can be shared with other machines)
+ * queue/shards.txt - root position, depth and number of jobs
+ * queue/pending/   - jobs that have not been claimed
+ * queue/running/   - jobs claimed by a worker (a worker claims a job by renaming it out of pending)
+ * queue/done/      - jobs with their node count (written to a temporary file and renamed, so a crash never leaves a partial result)
+ */
+namespace shard
+{
+    /**
+     * Creates a job in the queue directory for every position splitDepth moves from the root position (see PerftTestableEngine::perftSplit)
+     * The queue directory must be empty or not exist, and is only created once every job is written
+     * @return number of jobs created
+    */
+    int split(PerftTestableEngine& engine, const std::string& fen, int depth, int splitDepth, const std::string& queueDir);
+
+    /**
+     * Claims and runs jobs until there are no pending jobs left
+     * @return number of jobs run
+    */
+    int work(PerftTestableEngine& engine, const std::string& queueDir);
+
+    /**
+     * Moves the jobs left in running by crashed workers back to pending (must only be used while no workers are running)
+     * @return number of jobs put back in pending
+    */
+    int resume(const std::string& queueDir);
+
+    /**
+     * Adds up the finished jobs and prints out the node count of every root move
+     * @return true if every job is done
+    */
+    bool collect(const std::string& queueDir);
+}
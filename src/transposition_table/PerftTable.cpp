@@ -0,0 +1,56 @@
+#include "PerftTable.h"
+#include <cstdint>
+#include <cstddef>
+#include <initializer_list>
+
+
+static bool entryMatches(std::uint64_t keyXorData, std::uint64_t data, std::uint_fast64_t key, std::uint_fast8_t depth)
+{
+	return (keyXorData ^ data) == key && (data & 0xFF) == depth;
+}
+
+PerftTable::PerftTable(std::size_t megabytes)
+{
+	// Largest power of two number of buckets that fits (at least one)
+	numBuckets = 1;
+	while (numBuckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+		numBuckets *= 2;
+	}
+	buckets = std::make_unique<Bucket[]>(numBuckets);
+	clear();
+}
+
+void PerftTable::clear()
+{
+	// Depth 0 is never stored, so zeroed entries never match
+	for (std::uint_fast64_t i = 0; i < numBuckets; i++) {
+		for (Entry* entry : { &buckets[i].deepest, &buckets[i].recent }) {
+			entry->keyXorData.store(0, std::memory_order_relaxed);
+			entry->data.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+bool PerftTable::probe(std::uint_fast64_t key, std::uint_fast8_t depth, std::uint64_t& nodes) const
+{
+	const Bucket& bucket = buckets[key & (numBuckets - 1)];
+	for (const Entry* entry : { &bucket.deepest, &bucket.recent }) {
+		std::uint64_t keyXorData = entry->keyXorData.load(std::memory_order_relaxed);
+		std::uint64_t data = entry->data.load(std::memory_order_relaxed);
+		if (entryMatches(keyXorData, data, key, depth)) {
+			nodes = data >> 8;
+			return true;
+		}
+	}
+	return false;
+}
+
+void PerftTable::store(std::uint_fast64_t key, std::uint_fast8_t depth, std::uint64_t nodes)
+{
+	Bucket& bucket = buckets[key & (numBuckets - 1)];
+	std::uint64_t data = (nodes << 8) | depth;
+
+	Entry& entry = depth >= (bucket.deepest.data.load(std::memory_order_relaxed) & 0xFF) ? bucket.deepest : bucket.recent;
+	entry.keyXorData.store(key ^ data, std::memory_order_relaxed);
+	entry.data.store(data, std::memory_order_relaxed);
+}
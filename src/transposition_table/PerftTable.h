@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+
+// Hash table of perft node counts, keyed by position and depth
+// Entries are stored as (key ^ data, data), so it can be shared by perft threads without locks:
+// an entry torn by two threads storing at once fails the key check and is treated as a miss
+class PerftTable
+{
+public:
+	// Construct a new perft table of about the given size (rounded down to a power of two number of buckets)
+	PerftTable(std::size_t megabytes);
+
+	// Clear the entries in the perft table
+	void clear();
+
+	// returns true and sets nodes if the node count of the position at the given depth is stored
+	bool probe(std::uint_fast64_t key, std::uint_fast8_t depth, std::uint64_t& nodes) const;
+
+	// stores the node count of the position at the given depth (node counts must be below 2^56)
+	void store(std::uint_fast64_t key, std::uint_fast8_t depth, std::uint64_t nodes);
+
+private:
+	// | 56 bits nodes | 8 bits depth |
+	struct Entry
+	{
+		std::atomic<std::uint64_t> keyXorData;
+		std::atomic<std::uint64_t> data;
+	};
+
+	// The deepest entry is only replaced by an entry of at least the same depth, the other is always replaced
+	struct Bucket
+	{
+		Entry deepest;
+		Entry recent;
+	};
+
+	std::unique_ptr<Bucket[]> buckets;
+
+	std::uint_fast64_t numBuckets;
+};
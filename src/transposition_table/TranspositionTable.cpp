@@ -1,45 +1,222 @@
 #include "TranspositionTable.h"
 #include <cstdint>
+#include <cstddef>
+#include <new>
+#include <climits>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <algorithm>
 
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+
+// Position of the fields in Entry::data
+static constexpr int EVAL_TYPE_SHIFT = 8;
+static constexpr int AGE_SHIFT = 10;
+static constexpr int STATIC_EVAL_SHIFT = 16;
+static constexpr int EVAL_SHIFT = 32;
+static constexpr int MOVE_SHIFT = 48;
+static constexpr std::uint64_t AGE_MASK = 0b111111ULL << AGE_SHIFT;
+static constexpr std::uint64_t MOVE_MASK = 0xFFFFULL << MOVE_SHIFT;
+static constexpr std::uint64_t STATIC_EVAL_MASK = 0xFFFFULL << STATIC_EVAL_SHIFT;
 
 std::uint_fast8_t TranspositionTable::Entry::depth() const
 {
-	return static_cast<std::uint_fast8_t>(info >> 27);
+	return static_cast<std::uint_fast8_t>(data & 0xFF);
+}
+
+std::uint_fast8_t TranspositionTable::Entry::evalType() const
+{
+	return static_cast<std::uint_fast8_t>((data >> EVAL_TYPE_SHIFT) & 0b11);
+}
+
+std::uint_fast8_t TranspositionTable::Entry::age() const
+{
+	return static_cast<std::uint_fast8_t>((data & AGE_MASK) >> AGE_SHIFT);
+}
+
+std::int16_t TranspositionTable::Entry::eval() const
+{
+	return static_cast<std::int16_t>(data >> EVAL_SHIFT);
+}
+
+std::int16_t TranspositionTable::Entry::staticEval() const
+{
+	return static_cast<std::int16_t>(data >> STATIC_EVAL_SHIFT);
+}
+
+std::uint16_t TranspositionTable::Entry::move() const
+{
+	return static_cast<std::uint16_t>(data >> MOVE_SHIFT);
 }
 
 bool TranspositionTable::Entry::isHit(std::uint_fast64_t zobrist) const
 {
-	static constexpr std::uint32_t key_mask = (1 << 24) - 1;
-	return info && (static_cast<std::uint32_t>(zobrist >> 40) == (info & key_mask));
+	return data && key == zobrist;
 }
 
-TranspositionTable::Entry::Entry() : info(0), eval(0), move(0) {}
+TranspositionTable::Entry::Entry() : key(0), data(0) {}
+
+TranspositionTable::Entry::Entry(std::uint_fast64_t zobrist, std::uint_fast8_t depth, std::int16_t eval, std::uint_fast8_t evalType, std::uint16_t move, std::int16_t staticEval) : key(zobrist)
+{
+	data = static_cast<std::uint64_t>(move) << MOVE_SHIFT
+		| static_cast<std::uint64_t>(static_cast<std::uint16_t>(eval)) << EVAL_SHIFT
+		| static_cast<std::uint64_t>(static_cast<std::uint16_t>(staticEval)) << STATIC_EVAL_SHIFT
+		| static_cast<std::uint64_t>(evalType) << EVAL_TYPE_SHIFT
+		| depth;
+}
 
-TranspositionTable::Entry::Entry(std::uint_fast64_t zobrist, std::uint_fast8_t depth, std::int16_t eval, std::uint32_t evalType, std::uint_fast8_t start, std::uint_fast8_t target) : eval(eval)
+// Allocates zeroed memory for a large table straight from the OS, so it can be backed by huge pages
+// With 4KB pages almost every probe of a large table is a TLB miss, a 2MB page covers 512 times as many entries
+static void* allocateTable(std::size_t bytes)
 {
-	move = (static_cast<std::uint16_t>(start) << 8) | target;
-	info = (static_cast<std::uint32_t>(depth) << 27) | evalType | static_cast<std::uint32_t>(zobrist >> 40);
+#ifdef _WIN32
+	// Large pages on Windows need the "Lock pages in memory" privilege, so normal pages are used
+	void* memory = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+#else
+	void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		throw std::bad_alloc();
+	}
+#ifdef MADV_HUGEPAGE
+	// Only a hint, the table still works if transparent huge pages are disabled
+	madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+#endif
+	return memory;
 }
 
-TranspositionTable::TranspositionTable()
+static void freeTable(void* memory, std::size_t bytes)
 {
-	clear();
+#ifdef _WIN32
+	VirtualFree(memory, 0, MEM_RELEASE);
+#else
+	munmap(memory, bytes);
+#endif
 }
 
-void TranspositionTable::clear()
+TranspositionTable::TranspositionTable(std::size_t megabytes) : generation(0), game(0), keySalt(0)
 {
-	// Reset each entry to zero
-	for (int i = 0; i < NUM_ENTRIES; i++) {
-		entries[i] = Entry();
+	// Largest power of two number of clusters that fits (at least one)
+	std::uint_fast64_t numClusters = 1;
+	while (numClusters * 2 * sizeof(Cluster) <= megabytes * 1024 * 1024) {
+		numClusters *= 2;
 	}
+	indexMask = numClusters - 1;
+	// The memory is already zeroed, so there is no need to clear it (which would also touch every page up front)
+	clusters = static_cast<Cluster*>(allocateTable(size()));
+}
+
+TranspositionTable::~TranspositionTable()
+{
+	freeTable(clusters, size());
+}
+
+std::size_t TranspositionTable::size() const
+{
+	return (indexMask + 1) * sizeof(Cluster);
+}
+
+void TranspositionTable::clear(unsigned threads)
+{
+	// The table is never cleared during a search, so each thread can zero its share of the clusters directly
+	threads = std::max(threads, 1U);
+	std::uint_fast64_t numClusters = indexMask + 1;
+	auto clearShare = [this, numClusters, threads](unsigned thread) {
+		std::uint_fast64_t start = numClusters * thread / threads;
+		std::uint_fast64_t end = numClusters * (thread + 1) / threads;
+		std::memset(static_cast<void*>(clusters + start), 0, (end - start) * sizeof(Cluster));
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < threads; ++i) {
+		workers.emplace_back(clearShare, i);
+	}
+	clearShare(0);
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void TranspositionTable::newSearch()
+{
+	generation = (generation + 1) % NUM_AGES;
+}
+
+void TranspositionTable::newGame()
+{
+	// Any odd multiplier spreads the game count over every bit of the salt
+	keySalt = ++game * 0x9E3779B97F4A7C15ULL;
+	newSearch();
 }
 
 TranspositionTable::Entry TranspositionTable::getEntry(std::uint_fast64_t zobrist)
 {
-	return entries[zobrist % NUM_ENTRIES];
+	std::uint_fast64_t key = zobrist ^ keySalt;
+
+	// Relaxed ordering is enough, the entry is only used as a search hint and not to publish other data
+	for (const Slot& slot : clusters[key & indexMask].slots) {
+		std::uint64_t keyXorData = slot.keyXorData.load(std::memory_order_relaxed);
+		std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+		if (data && (keyXorData ^ data) == key) {
+			// Callers check the hit against the unsalted hash
+			Entry entry;
+			entry.key = zobrist;
+			entry.data = data;
+			return entry;
+		}
+	}
+	return Entry();
 }
 
 void TranspositionTable::storeEntry(Entry entry, std::uint_fast64_t zobrist)
 {
-	entries[zobrist % NUM_ENTRIES] = entry;
+	static_assert(searchesSince(5, 7) == 2 && searchesSince(62, 1) == 3 && searchesSince(NUM_AGES - 1, 0) == 1, "entry ages must count searches across the wrap around");
+
+	std::uint_fast64_t key = zobrist ^ keySalt;
+	std::uint64_t data = (entry.data & ~AGE_MASK) | static_cast<std::uint64_t>(generation) << AGE_SHIFT;
+
+	Slot* replace = nullptr;
+	int lowestWorth = INT_MAX;
+	for (Slot& slot : clusters[key & indexMask].slots) {
+		Entry stored;
+		stored.data = slot.data.load(std::memory_order_relaxed);
+		stored.key = slot.keyXorData.load(std::memory_order_relaxed) ^ stored.data;
+
+		// Entry of the same position
+		if (stored.isHit(key)) {
+			if (entry.depth() >= stored.depth() || stored.age() != generation) {
+				if (!entry.move()) {
+					data |= stored.data & MOVE_MASK;
+				}
+				// The static eval does not depend on the search, so one stored by quiscence search stays valid
+				if (entry.staticEval() == Entry::NO_STATIC_EVAL) {
+					data = (data & ~STATIC_EVAL_MASK) | (stored.data & STATIC_EVAL_MASK);
+				}
+				slot.keyXorData.store(key ^ data, std::memory_order_relaxed);
+				slot.data.store(data, std::memory_order_relaxed);
+			}
+			return;
+		}
+
+		// Empty entries are used first, then the shallowest after counting a ply less for each search since it was stored
+		int searchesAgo = searchesSince(stored.age(), generation);
+		int worth = stored.data ? stored.depth() - searchesAgo : INT_MIN;
+		if (worth < lowestWorth) {
+			lowestWorth = worth;
+			replace = &slot;
+		}
+	}
+	replace->keyXorData.store(key ^ data, std::memory_order_relaxed);
+	replace->data.store(data, std::memory_order_relaxed);
 }
@@ -1,5 +1,10 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <atomic>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
 
 
 class TranspositionTable
@@ -7,40 +12,126 @@ class TranspositionTable
 public:
 	struct Entry
 	{
-		// | 5 bits depth (MAX 31!!) | 3 bits eval_type | 24 bits key (most significant 24 from hash) |
-		std::uint32_t info;
+		// Hash of the position
+		std::uint64_t key;
 
-		// Eval
-		std::int16_t eval;
+		// | 16 bits move | 16 bits eval | 16 bits static eval | 6 bits age | 2 bits eval_type | 8 bits depth |
+		// Every stored entry has an eval type, so an empty entry is 0
+		std::uint64_t data;
 
-		// Best move | 8 bits start square | 8 bits target square |
-		std::uint16_t move;
+		static constexpr std::uint_fast8_t EXACT_VALUE = 1;
+		static constexpr std::uint_fast8_t LOWER_BOUND = 2;
+		static constexpr std::uint_fast8_t UPPER_BOUND = 3;
 
-		static constexpr std::uint32_t EXACT_VALUE = (1 << 24);
-		static constexpr std::uint32_t LOWER_BOUND = (1 << 25);
-		static constexpr std::uint32_t UPPER_BOUND = (1 << 26);
+		// Static eval of a position that was not evaluated
+		static constexpr std::int16_t NO_STATIC_EVAL = INT16_MIN;
 
 		std::uint_fast8_t depth() const;
 
+		std::uint_fast8_t evalType() const;
+
+		// Generation of the table when the entry was stored
+		std::uint_fast8_t age() const;
+
+		// Search result (exact or a bound depending on the eval type)
+		// Engines store mate scores relative to the position of the entry, not the root
+		std::int16_t eval() const;
+
+		std::int16_t staticEval() const;
+
+		// Best move in the engine's own 16 bit encoding (0 if there is none)
+		std::uint16_t move() const;
+
 		bool isHit(std::uint_fast64_t zobrist) const;
 
 		Entry();
 
-		Entry(std::uint_fast64_t zobrist, std::uint_fast8_t depth, std::int16_t eval, std::uint32_t evalType, std::uint_fast8_t start, std::uint_fast8_t target);
+		Entry(std::uint_fast64_t zobrist, std::uint_fast8_t depth, std::int16_t eval, std::uint_fast8_t evalType, std::uint16_t move, std::int16_t staticEval = NO_STATIC_EVAL);
 	};
 
-	static constexpr std::uint_fast64_t NUM_ENTRIES = (1 << 20);
+	// Size of the table when none is given (2^19 entries)
+	static constexpr std::size_t DEFAULT_MEGABYTES = 8;
+
+	// Entries sharing an index, which fill a 64 byte cache line
+	static constexpr std::size_t CLUSTER_SIZE = 4;
+
+	// Entries are stored as (key ^ data, data) so threads can share the table without locks:
+	// an entry torn by two threads storing at once fails the key check and is treated as a miss
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "transposition table entries must be lock-free");
 
-	// Construct a new transposition table
-	TranspositionTable();
+	// Construct a new transposition table of about the given size (rounded down to a power of two number of clusters)
+	// The entries are allocated with mmap and backed by transparent huge pages where the system supports them
+	TranspositionTable(std::size_t megabytes = DEFAULT_MEGABYTES);
 
-	// Clear the entries in the transposition table
-	void clear();
+	~TranspositionTable();
 
+	TranspositionTable(const TranspositionTable&) = delete;
+
+	TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+	// returns the size of the table in bytes
+	std::size_t size() const;
+
+	// Clear the entries in the transposition table, split over the given number of threads (only worth it for large tables)
+	void clear(unsigned threads = 1);
+
+	// Starts a new generation, entries stored before it are replaced first (call before every search)
+	void newSearch();
+
+	// Starts a new game without touching the entries: positions are keyed with a different salt, so older entries can no longer be hit
+	// (they only collide with new positions as often as any other entry does) and, being from an older generation, they are replaced first
+	void newGame();
+
+	// Starts loading the cluster of the position into the cache without waiting for it
+	// Issued as soon as a move's hash is known, so the probe of the new position does not stall on memory
+	void prefetch(std::uint_fast64_t zobrist) const
+	{
+		const Cluster* cluster = &clusters[(zobrist ^ keySalt) & indexMask];
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_prefetch(reinterpret_cast<const char*>(cluster), _MM_HINT_T0);
+#elif defined(__GNUC__)
+		__builtin_prefetch(cluster);
+#endif
+	}
+
+	// returns the entry of the position in its cluster (an empty entry if there is none)
 	Entry getEntry(std::uint_fast64_t zobrist);
 
+	// Replaces the entry of the same position if the new entry is at least as deep or the old one is from an older search
+	// (keeping the old move and static eval if the new entry has none)
+	// Otherwise the new entry replaces the entry of the cluster with the lowest depth, counting 1 ply less for every search since it was stored
 	void storeEntry(Entry entry, std::uint_fast64_t zobrist);
 
 private:
-	Entry entries[NUM_ENTRIES];
+	// Number of generations before the age wraps around (6 bits)
+	static constexpr std::uint_fast8_t NUM_AGES = 64;
+
+	// Number of searches since an entry of the given age was stored (the generation may have wrapped around since)
+	static constexpr int searchesSince(std::uint_fast8_t age, std::uint_fast8_t generation)
+	{
+		return (NUM_AGES + generation - age) % NUM_AGES;
+	}
+
+	struct Slot
+	{
+		std::atomic<std::uint64_t> keyXorData;
+		std::atomic<std::uint64_t> data;
+	};
+
+	struct alignas(64) Cluster
+	{
+		Slot slots[CLUSTER_SIZE];
+	};
+
+	Cluster* clusters;
+
+	// Number of clusters - 1 (the number of clusters is a power of two)
+	std::uint_fast64_t indexMask;
+
+	// Age given to stored entries
+	std::uint_fast8_t generation;
+
+	// Number of games started, and the value xored into every key for the current game
+	std::uint64_t game;
+	std::uint64_t keySalt;
 };
\ No newline at end of file
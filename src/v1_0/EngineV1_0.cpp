@@ -58,6 +58,15 @@ std::vector<StandardMove> EngineV1_0::getLegalMoves() noexcept
     return moves;
 }
 
+std::size_t EngineV1_0::getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept
+{
+    std::size_t count = std::min(capacity, enginePositionMoves.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        moves[i] = StandardMove(enginePositionMoves[i].start(), enginePositionMoves[i].target(), enginePositionMoves[i].promotion());
+    }
+    return enginePositionMoves.size();
+}
+
 int EngineV1_0::colorToMove() noexcept
 {
     return 1 - 2 * (totalHalfmoves % 2);
@@ -129,7 +138,7 @@ void EngineV1_0::inputMove(const StandardMove& move)
     for (Move& legalMove : enginePositionMoves) {
         if (legalMove == move) {
             makeMove(legalMove);
-            enginePositionMoves = legalMoves();
+            legalMoves(enginePositionMoves);
             return;
         }
     }
@@ -635,7 +644,7 @@ void EngineV1_0::initializeFen(const std::string& fenString)
         }
     }
 
-    enginePositionMoves = legalMoves();
+    legalMoves(enginePositionMoves);
 }
 
 void EngineV1_0::generatePseudoLegalMoves(Move* stack, int16& idx) const
@@ -1262,21 +1271,19 @@ moveGeneration:
     }
 }
 
-std::vector<EngineV1_0::Move> EngineV1_0::legalMoves()
+void EngineV1_0::legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves)
 {
-    Move moves[225];
+    Move stack[225];
     int16 end = 0;
-    generatePseudoLegalMoves(moves, end);
+    generatePseudoLegalMoves(stack, end);
 
-    std::vector<Move> legalMoves;
+    moves.clear();
 
     for (int i = 0; i < end; ++i) {
-        if (isLegal(moves[i])) {
-            legalMoves.push_back(moves[i]);
+        if (isLegal(stack[i])) {
+            moves.push_back(stack[i]);
         }
     }
-
-    return legalMoves;
 }
 
 bool EngineV1_0::makeMove(EngineV1_0::Move& move)
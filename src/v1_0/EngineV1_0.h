@@ -1,6 +1,7 @@
 #pragma once
 #include "StandardEngine.h"
 #include "StandardMove.h"
+#include "MoveList.h"
 
 typedef std::int_fast16_t int16;
 typedef std::int_fast8_t int8;
@@ -21,6 +22,8 @@ public:
 
     std::vector<StandardMove> getLegalMoves() noexcept override;
 
+    std::size_t getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept override;
+
     int colorToMove() noexcept override;
 
     StandardMove computerMove(std::chrono::milliseconds thinkTime) override;
@@ -176,7 +179,7 @@ private:
 
     // SEARCH/EVALUATION MEMBERS
     // Legal moves for the current position stored in the engine
-    std::vector<Move> enginePositionMoves;
+    MoveList<Move, MAX_LEGAL_MOVES> enginePositionMoves;
 
     // Inbalance of peice placement, used for evaluation function 
     int16 material_stage_weight;
@@ -210,9 +213,9 @@ private:
     // Doesnt generate all pseudo legal moves, omits moves that are guarenteed to be illegal
     void generatePseudoLegalMoves(Move* stack, int16& idx) const;
 
-    // Generates legal moves for the current position
+    // Replaces the moves with the legal moves for the current position
     // Not as fast as pseudoLegalMoves() for searching
-    std::vector<Move> legalMoves();
+    void legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves);
 
     // update the board based on the inputted move (must be pseudo legal)
     // returns true if move was legal and process completed
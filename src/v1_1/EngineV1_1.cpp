@@ -66,6 +66,15 @@ std::vector<StandardMove> EngineV1_1::getLegalMoves() noexcept
     return moves;
 }
 
+std::size_t EngineV1_1::getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept
+{
+    std::size_t count = std::min(capacity, enginePositionMoves.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        moves[i] = StandardMove(enginePositionMoves[i].start(), enginePositionMoves[i].target(), enginePositionMoves[i].promotion());
+    }
+    return enginePositionMoves.size();
+}
+
 int EngineV1_1::colorToMove() noexcept
 {
     return 1 - 2 * (totalHalfmoves % 2);
@@ -118,7 +127,7 @@ StandardMove EngineV1_1::computerMove(std::chrono::milliseconds thinkTime)
         // Save last evaluation in case of time cutoff
         lastEval = enginePositionMoves[0].strengthGuess;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
+        // Erase scores from last iteration (sortByScore will maintain order)
         for (Move& move : enginePositionMoves) {
             move.strengthGuess = -MAX_EVAL;
         }
@@ -140,7 +149,7 @@ StandardMove EngineV1_1::computerMove(std::chrono::milliseconds thinkTime)
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
+        enginePositionMoves.sortByScore([](const Move& move) { return move.strengthGuess; });
 //        std::cout << " bestmove " << enginePositionMoves[0].toString();
 
 //        std::cout << " nodes " << nodesSearchedThisMove - nodesSearchedBeforeThisIteration;
@@ -187,7 +196,7 @@ void EngineV1_1::inputMove(const StandardMove& move)
 
             makeMove(legalMove);
 
-            enginePositionMoves = legalMoves();
+            legalMoves(enginePositionMoves);
 
             if (positionInfoIndex > 51 || positionInfoIndex == 0) {
                 throw std::runtime_error("Position info index shouldnt be this high/low!!");
@@ -358,7 +367,7 @@ std::uint64_t EngineV1_1::search_perft(int depth) noexcept
     for (int d = 0; d < depth; ++d) {
         int32 alpha = -MAX_EVAL;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
+        // Erase scores from last iteration (sortByScore will maintain order)
         for (Move& move : enginePositionMoves) {
             move.strengthGuess = -MAX_EVAL;
         }
@@ -377,7 +386,7 @@ std::uint64_t EngineV1_1::search_perft(int depth) noexcept
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
+        enginePositionMoves.sortByScore([](const Move& move) { return move.strengthGuess; });
     }
 
     auto end = std::chrono::high_resolution_clock::now();
@@ -416,7 +425,7 @@ std::uint64_t EngineV1_1::search_perft(std::chrono::milliseconds thinkTime) noex
 
         int32 alpha = -MAX_EVAL;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
+        // Erase scores from last iteration (sortByScore will maintain order)
         for (Move& move : enginePositionMoves) {
             move.strengthGuess = -MAX_EVAL;
         }
@@ -437,7 +446,7 @@ std::uint64_t EngineV1_1::search_perft(std::chrono::milliseconds thinkTime) noex
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
+        enginePositionMoves.sortByScore([](const Move& move) { return move.strengthGuess; });
 
         if (std::chrono::high_resolution_clock::now() > searchCutoff) {
             break;
@@ -834,7 +843,7 @@ void EngineV1_1::initializeFen(const std::string& fenString)
 
     uint8 c = totalHalfmoves % 2;
 
-    enginePositionMoves = legalMoves();
+    legalMoves(enginePositionMoves);
 }
 
 bool EngineV1_1::generatePseudoLegalMoves(Move* stack, uint32& idx, bool generateOnlyCaptures) noexcept
@@ -1467,21 +1476,19 @@ moveGeneration:
     return checks;
 }
 
-std::vector<EngineV1_1::Move> EngineV1_1::legalMoves()
+void EngineV1_1::legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves)
 {
-    Move moves[225];
+    Move stack[225];
     uint32 end = 0;
-    generatePseudoLegalMoves(moves, end);
+    generatePseudoLegalMoves(stack, end);
 
-    std::vector<Move> legalMoves;
+    moves.clear();
 
     for (uint32 i = 0; i < end; ++i) {
-        if (isLegal(moves[i])) {
-            legalMoves.push_back(moves[i]);
+        if (isLegal(stack[i])) {
+            moves.push_back(stack[i]);
         }
     }
-
-    return legalMoves;
 }
 
 void EngineV1_1::generateCaptures(Move* stack, uint32& idx, bool* pinnedPeices) const
@@ -2,6 +2,7 @@
 #include "StandardEngine.h"
 #include "PerftTestableEngine.h"
 #include "StandardMove.h"
+#include "MoveList.h"
 
 #include <cstdint>
 #include <optional>
@@ -26,6 +27,8 @@ public:
 
     std::vector<StandardMove> getLegalMoves() noexcept override;
 
+    std::size_t getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept override;
+
     int colorToMove() noexcept override;
 
     StandardMove computerMove(std::chrono::milliseconds thinkTime) override;
@@ -180,7 +183,7 @@ private:
 
     // SEARCH/EVALUATION MEMBERS
     // Legal moves for the current position stored in the engine
-    std::vector<Move> enginePositionMoves;
+    MoveList<Move, MAX_LEGAL_MOVES> enginePositionMoves;
 
     // Inbalance of peice placement, used for evaluation function 
     std::uint_fast8_t material_stage_weight;
@@ -220,9 +223,9 @@ private:
     // Returns true of the king was in check
     bool generatePseudoLegalMoves(Move* stack, std::uint_fast32_t& idx, bool generateOnlyCaptures = false) noexcept;
 
-    // Generates legal moves for the current position
+    // Replaces the moves with the legal moves for the current position
     // Not as fast as pseudoLegalMoves() for searching
-    std::vector<Move> legalMoves();
+    void legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves);
 
     // Generates pseudo-legal captures for the current position
     // Populates the stack starting from the given index
@@ -67,6 +67,15 @@ std::vector<StandardMove> EngineV1_2::getLegalMoves() noexcept
     return moves;
 }
 
+std::size_t EngineV1_2::getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept
+{
+    std::size_t count = std::min(capacity, enginePositionMoves.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        moves[i] = StandardMove(enginePositionMoves[i].start(), enginePositionMoves[i].target(), enginePositionMoves[i].promotion());
+    }
+    return enginePositionMoves.size();
+}
+
 int EngineV1_2::colorToMove() noexcept
 {
     return 1 - 2 * (totalHalfmoves % 2);
@@ -118,7 +127,7 @@ StandardMove EngineV1_2::computerMove(std::chrono::milliseconds thinkTime)
         // Save last evaluation in case of time cutoff
         lastEval = enginePositionMoves[0].strengthGuess;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
+        // Erase scores from last iteration (sortByScore will maintain order)
         for (Move& move : enginePositionMoves) {
             move.strengthGuess = -MAX_EVAL;
         }
@@ -140,7 +149,7 @@ StandardMove EngineV1_2::computerMove(std::chrono::milliseconds thinkTime)
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
+        enginePositionMoves.sortByScore([](const Move& move) { return move.strengthGuess; });
         //std::cout << " bestmove " << enginePositionMoves[0].toString();
 
         //std::cout << " nodes " << nodesSearchedThisMove - nodesSearchedBeforeThisIteration;
@@ -187,7 +196,7 @@ void EngineV1_2::inputMove(const StandardMove& move)
 
             makeMove(legalMove);
 
-            enginePositionMoves = legalMoves();
+            legalMoves(enginePositionMoves);
 
             if (positionInfoIndex > 51 || positionInfoIndex == 0) {
                 throw std::runtime_error("Position info index shouldnt be this high/low!!");
@@ -358,7 +367,7 @@ std::uint64_t EngineV1_2::search_perft(int depth) noexcept
     for (int d = 0; d < depth; ++d) {
         int32 alpha = -MAX_EVAL;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
+        // Erase scores from last iteration (sortByScore will maintain order)
         for (Move& move : enginePositionMoves) {
             move.strengthGuess = -MAX_EVAL;
         }
@@ -377,7 +386,7 @@ std::uint64_t EngineV1_2::search_perft(int depth) noexcept
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
+        enginePositionMoves.sortByScore([](const Move& move) { return move.strengthGuess; });
     }
 
     auto end = std::chrono::high_resolution_clock::now();
@@ -416,7 +425,7 @@ std::uint64_t EngineV1_2::search_perft(std::chrono::milliseconds thinkTime) noex
 
         int32 alpha = -MAX_EVAL;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
+        // Erase scores from last iteration (sortByScore will maintain order)
         for (Move& move : enginePositionMoves) {
             move.strengthGuess = -MAX_EVAL;
         }
@@ -437,7 +446,7 @@ std::uint64_t EngineV1_2::search_perft(std::chrono::milliseconds thinkTime) noex
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
+        enginePositionMoves.sortByScore([](const Move& move) { return move.strengthGuess; });
 
         if (std::chrono::high_resolution_clock::now() > searchCutoff) {
             break;
@@ -852,7 +861,7 @@ void EngineV1_2::initializeFen(const std::string& fenString)
 
     uint8 c = totalHalfmoves % 2;
 
-    enginePositionMoves = legalMoves();
+    legalMoves(enginePositionMoves);
 }
 
 bool EngineV1_2::generatePseudoLegalMoves(Move* stack, uint32& idx, bool generateOnlyCaptures) noexcept
@@ -1485,21 +1494,19 @@ moveGeneration:
     return checks;
 }
 
-std::vector<EngineV1_2::Move> EngineV1_2::legalMoves()
+void EngineV1_2::legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves)
 {
-    Move moves[225];
+    Move stack[225];
     uint32 end = 0;
-    generatePseudoLegalMoves(moves, end);
+    generatePseudoLegalMoves(stack, end);
 
-    std::vector<Move> legalMoves;
+    moves.clear();
 
     for (uint32 i = 0; i < end; ++i) {
-        if (isLegal(moves[i])) {
-            legalMoves.push_back(moves[i]);
+        if (isLegal(stack[i])) {
+            moves.push_back(stack[i]);
         }
     }
-
-    return legalMoves;
 }
 
 void EngineV1_2::generateCaptures(Move* stack, uint32& idx, bool* pinnedPeices) const
@@ -2264,22 +2271,22 @@ int32 EngineV1_2::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, ui
     // Extract information from stored evaluation
     if (ttableEntryValid && ttableEntry.depth() >= depth) {
 
-        if (ttableEntry.info & ttableEntry.EXACT_VALUE) {
-            return ttableEntry.eval;
+        if (ttableEntry.evalType() == ttableEntry.EXACT_VALUE) {
+            return ttableEntry.eval();
         }
-        else if (ttableEntry.info & ttableEntry.LOWER_BOUND) {
-            if (ttableEntry.eval > alpha) {
-                alpha = ttableEntry.eval;
+        else if (ttableEntry.evalType() == ttableEntry.LOWER_BOUND) {
+            if (ttableEntry.eval() > alpha) {
+                alpha = ttableEntry.eval();
             }
         }
         else {
-            if (ttableEntry.eval < beta) {
-                beta = ttableEntry.eval;
+            if (ttableEntry.eval() < beta) {
+                beta = ttableEntry.eval();
             }
         }
 
         if (alpha >= beta) {
-            return ttableEntry.eval;
+            return ttableEntry.eval();
         }
     }
 
@@ -2299,8 +2306,8 @@ int32 EngineV1_2::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, ui
     MoveOrderer pseudoLegalMoves(moveStack, startMoves, endMoves);
 
     // Search the stored transposition table move first
-    if (ttableEntryValid && ttableEntry.move) {
-        Move move = Move(this, static_cast<uint8>(ttableEntry.move >> 8), static_cast<uint8>(ttableEntry.move & 0b11111111));
+    if (ttableEntryValid && ttableEntry.move()) {
+        Move move = Move(this, static_cast<uint8>(ttableEntry.move() >> 8), static_cast<uint8>(ttableEntry.move() & 0b11111111));
 
         // omit move because it has already been searched
         if (pseudoLegalMoves.omitMove(move) && makeMove(move)) {
@@ -2313,7 +2320,7 @@ int32 EngineV1_2::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, ui
 
             if (bestEval >= beta) {
                 if (!ttableEntryValid || depth > ttableEntry.depth()) {
-                    ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, beta, ttableEntry.LOWER_BOUND, bestMove.start(), bestMove.target()), zobrist);
+                    ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, beta, ttableEntry.LOWER_BOUND, bestMove.start() << 8 | bestMove.target()), zobrist);
                 }
                 return beta; // Cut node (lower bound)
             }
@@ -2339,7 +2346,7 @@ int32 EngineV1_2::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, ui
 
             if (eval >= beta) {
                 if (!ttableEntryValid || depth > ttableEntry.depth()) {
-                    ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, beta, ttableEntry.LOWER_BOUND, bestMove.start(), bestMove.target()), zobrist);
+                    ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, beta, ttableEntry.LOWER_BOUND, bestMove.start() << 8 | bestMove.target()), zobrist);
                 }
                 return beta; // Cut node (lower bound)
             }
@@ -2361,7 +2368,7 @@ int32 EngineV1_2::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, ui
     }
 
     if (!ttableEntryValid || depth > ttableEntry.depth()) {
-        ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, bestEval, evalType, bestMove.start(), bestMove.target()), zobrist);
+        ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, bestEval, evalType, bestMove.start() << 8 | bestMove.target()), zobrist);
     }
 
     return bestEval;
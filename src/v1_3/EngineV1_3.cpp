@@ -5,7 +5,6 @@
 #include <iomanip>
 #include <optional>
 #include <vector>
-#include <unordered_set>
 #include <algorithm>
 #include <stdexcept>
 #include <string>
@@ -13,11 +12,19 @@
 #include <cctype>
 #include <chrono>
 #include <cmath>
+#include <array>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <deque>
 
 #include <random>
+#include <atomic>
+#include <functional>
 
 #include "StandardMove.h"
 #include "precomputed_chess_data.h"
+#include "bitboards.h"
 #include "chesshelpers.h"
 #include "TranspositionTable.h"
 
@@ -34,18 +41,127 @@ constexpr int32 MATE_CUTOFF = MAX_EVAL - MAX_DEPTH;
 // Prevents computer from always choosing threefold repitition
 constexpr int32 REPITIION_EVALUATION = -50;
 
+// Depth of quiscence search entries in the transposition table (below every full search entry)
+constexpr uint8 QUISCENCE_DEPTH = 0;
+
+// Mate scores count plies from the root, but transposition table entries can be reached at any ply
+// so they are stored as plies from the entry's position instead
+static std::int16_t evalToTable(int32 eval, uint8 plyFromRoot)
+{
+    if (eval >= MATE_CUTOFF) {
+        return static_cast<std::int16_t>(std::min<int32>(eval + plyFromRoot, MAX_EVAL));
+    }
+    if (eval <= -MATE_CUTOFF) {
+        return static_cast<std::int16_t>(std::max<int32>(eval - plyFromRoot, -MAX_EVAL));
+    }
+    return static_cast<std::int16_t>(eval);
+}
+
+static int32 evalFromTable(int32 eval, uint8 plyFromRoot)
+{
+    if (eval >= MATE_CUTOFF) {
+        return eval - plyFromRoot;
+    }
+    if (eval <= -MATE_CUTOFF) {
+        return eval + plyFromRoot;
+    }
+    return eval;
+}
+
+// Castling rights bits for white (shifted left by 2 for black)
+constexpr uint8 KINGSIDE_CASTLING = 0b01;
+constexpr uint8 QUEENSIDE_CASTLING = 0b10;
+
+// Castling rights that remain after a peice moves from or to each square
+constexpr std::array<uint8, 64> CASTLING_RIGHTS_KEPT = [] {
+    std::array<uint8, 64> kept{};
+    for (uint8& rights : kept) {
+        rights = 0b1111;
+    }
+    kept[4] = ~(KINGSIDE_CASTLING | QUEENSIDE_CASTLING) & 0b1111;
+    kept[7] = ~KINGSIDE_CASTLING & 0b1111;
+    kept[0] = ~QUEENSIDE_CASTLING & 0b1111;
+    kept[60] = ~((KINGSIDE_CASTLING | QUEENSIDE_CASTLING) << 2) & 0b1111;
+    kept[63] = ~(KINGSIDE_CASTLING << 2) & 0b1111;
+    kept[56] = ~(QUEENSIDE_CASTLING << 2) & 0b1111;
+    return kept;
+}();
+
+// Shifts every square of the bitboard by the given number of squares (towards h8 if positive)
+template <int squares>
+constexpr uint64 shifted(uint64 bb) noexcept
+{
+    if constexpr (squares > 0) {
+        return bb << squares;
+    }
+    else {
+        return bb >> -squares;
+    }
+}
+
+// Returns the zobrist keys of the given castling rights xored together
+static uint64 castlingRightsZobrist(uint8 rights) noexcept
+{
+    uint64 key = 0;
+    for (uint8 c = 0; c < 2; ++c) {
+        if (rights & KINGSIDE_CASTLING << 2 * c) {
+            key ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[c];
+        }
+        if (rights & QUEENSIDE_CASTLING << 2 * c) {
+            key ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[c];
+        }
+    }
+    return key;
+}
+
+// Tasks of a single perft thread, other threads steal from the front when they run out of their own
+struct PerftTaskQueue
+{
+    std::mutex mutex;
+    std::deque<uint32> tasks;
+};
+
+// Takes a task from the back of the thread's own queue, or steals one from the front of another queue
+// returns false once every queue is empty
+static bool takePerftTask(std::vector<PerftTaskQueue>& queues, unsigned thread, uint32& task)
+{
+    for (unsigned i = 0; i < queues.size(); ++i) {
+        unsigned victim = (thread + i) % queues.size();
+        std::lock_guard<std::mutex> lock(queues[victim].mutex);
+        if (!queues[victim].tasks.empty()) {
+            if (victim == thread) {
+                task = queues[victim].tasks.back();
+                queues[victim].tasks.pop_back();
+            }
+            else {
+                task = queues[victim].tasks.front();
+                queues[victim].tasks.pop_front();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Depths skipped by the lazy SMP helper threads, which spreads them over the depth of the main thread and the next few
+// Helper i skips a depth if (depth + phase) / size is odd, using index (i - 1) % 20 of the tables
+constexpr std::array<uint8, 20> HELPER_SKIP_SIZE = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+constexpr std::array<uint8, 20> HELPER_SKIP_PHASE = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
 // TODO add some sort of protection for games with halfmove counter > 500
 
 // PUBLIC METHODS
-EngineV1_3::EngineV1_3(const std::string& fenString) : ttable(std::make_unique<TranspositionTable>())
+EngineV1_3::EngineV1_3(const std::string& fenString) : searchThreads(1), stopSearch(nullptr), ttable(std::make_shared<TranspositionTable>())
 {
     nnue = NNUE();
+    setPerftThreads(std::thread::hardware_concurrency());
     loadFEN(fenString);
 }
 
-EngineV1_3::EngineV1_3() : ttable(std::make_unique<TranspositionTable>())
+EngineV1_3::EngineV1_3() : searchThreads(1), stopSearch(nullptr), ttable(std::make_shared<TranspositionTable>())
 {
     nnue = NNUE();
+    setPerftThreads(std::thread::hardware_concurrency());
     loadStartingPosition();
 }
 
@@ -70,9 +186,18 @@ std::vector<StandardMove> EngineV1_3::getLegalMoves() noexcept
     return moves;
 }
 
+std::size_t EngineV1_3::getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept
+{
+    std::size_t count = std::min(capacity, enginePositionMoves.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        moves[i] = StandardMove(enginePositionMoves[i].start(), enginePositionMoves[i].target(), enginePositionMoves[i].promotion());
+    }
+    return enginePositionMoves.size();
+}
+
 int EngineV1_3::colorToMove() noexcept
 {
-    return 1 - 2 * (totalHalfmoves % 2);
+    return 1 - 2 * (pos.totalHalfmoves % 2);
 }
 
 StandardMove EngineV1_3::computerMove(std::chrono::milliseconds thinkTime)
@@ -90,19 +215,25 @@ StandardMove EngineV1_3::computerMove(std::chrono::milliseconds thinkTime)
     std::chrono::nanoseconds lastSearchDuration(0);
     std::chrono::milliseconds totalSearchTime(0);
 
-    Move moveStack[1500];
+    MoveList<Move, MOVE_STACK_CAPACITY> moveStack;
 
     std::cout << "SEARCH " << asFEN() << std::endl;
 
     // Order moves
-    for (Move& move : enginePositionMoves) {
-        MoveOrderer::generateStrengthGuess(this, move);
-    }
-    std::sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](Move& l, Move& r) { return l.strengthGuess > r.strengthGuess; });
+    MoveList<RootMove, MAX_LEGAL_MOVES> moves = rootMoves();
 
     // Used for saving last iteration's eval
     int32 lastEval;
 
+    // Number of plies of the deepest iteration that searched every root move
+    uint8 completedDepth = 0;
+
+    // Entries from earlier searches are replaced first
+    ttable->newSearch();
+
+    SearchHelpers helpers;
+    startSearchHelpers(helpers);
+
     // Incrementally increase depth until time is up
     uint8 depth = 0;
     for (; depth < MAX_DEPTH - 1; ++depth) {
@@ -119,32 +250,39 @@ StandardMove EngineV1_3::computerMove(std::chrono::milliseconds thinkTime)
         int index = 0;
 
         // Save last evaluation in case of time cutoff
-        lastEval = enginePositionMoves[0].strengthGuess;
+        lastEval = moves[0].score;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
-        for (Move& move : enginePositionMoves) {
-            move.strengthGuess = -MAX_EVAL;
+        // Erase scores from last iteration (sortByScore will maintain order)
+        for (RootMove& rootMove : moves) {
+            rootMove.score = -MAX_EVAL;
         }
 
+        bool timeout = false;
+
         // Run search for each move
-        for (Move& move : enginePositionMoves) {
+        for (RootMove& rootMove : moves) {
             if (std::chrono::high_resolution_clock::now() > searchCutoff) {
                 //std::cout << " timeout";
+                timeout = true;
                 break;
             }
 
-            makeMove(move, 0);
-            move.strengthGuess = -search_std(1, depth, moveStack, 0, -MAX_EVAL, -alpha);
-            unmakeMove(move);
+            makeMove(rootMove.move, 0);
+            rootMove.score = -search_std(1, depth, moveStack.data(), 0, -MAX_EVAL, -alpha);
+            unmakeMove(rootMove.move);
 
-            if (move.strengthGuess > alpha) {
-                alpha = move.strengthGuess;
+            if (rootMove.score > alpha) {
+                alpha = rootMove.score;
             }
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
-        //std::cout << " bestmove " << enginePositionMoves[0].toString();
+        moves.sortByScore([](const RootMove& rootMove) { return rootMove.score; });
+        //std::cout << " bestmove " << moves[0].move.toString();
+
+        if (!timeout) {
+            completedDepth = depth + 1;
+        }
 
         //std::cout << " nodes " << nodesSearchedThisMove - nodesSearchedBeforeThisIteration;
 
@@ -154,7 +292,7 @@ StandardMove EngineV1_3::computerMove(std::chrono::milliseconds thinkTime)
         //std::cout << " time " << std::chrono::duration_cast<std::chrono::milliseconds>(lastSearchDuration).count() << "millis" << std::endl;
 
         // Fastest mate is already found
-        if (std::abs(enginePositionMoves[0].strengthGuess) >= MATE_CUTOFF) {
+        if (std::abs(moves[0].score) >= MATE_CUTOFF) {
             break;
         }
 
@@ -164,14 +302,30 @@ StandardMove EngineV1_3::computerMove(std::chrono::milliseconds thinkTime)
     }
 
 
+    stopSearchHelpers(helpers);
+
     // Return the best move
-    Move bestMove = enginePositionMoves[0];
+    Move bestMove = moves[0].move;
+
+    int32 eval = moves[0].score == -MAX_EVAL ? lastEval : moves[0].score;
+    std::uint64_t nodes = nodesSearchedThisMove;
+    int reportedDepth = depth + 1;
+
+    // A helper that completed a deeper iteration than the main thread has the better move
+    for (const HelperResult& result : helpers.results) {
+        nodes += result.nodes;
+        if (result.depth > completedDepth) {
+            completedDepth = result.depth;
+            bestMove = result.move;
+            eval = result.score;
+            reportedDepth = std::max<int>(reportedDepth, result.depth);
+        }
+    }
 
-    int32 eval = bestMove.strengthGuess == -MAX_EVAL ? lastEval : bestMove.strengthGuess;
     std::string evalString = std::abs(eval) > MATE_CUTOFF ? "#" + std::to_string(MAX_EVAL - std::abs(eval)) : std::to_string(colorToMove() * eval);
 
-    std::cout << std::setw(8) << std::left << ("depth " + std::to_string(depth + 1));
-    std::cout << std::setw(14) << std::left << (" nodes " + std::to_string(nodesSearchedThisMove));
+    std::cout << std::setw(8) << std::left << ("depth " + std::to_string(reportedDepth));
+    std::cout << std::setw(14) << std::left << (" nodes " + std::to_string(nodes));
     std::cout << std::setw(12) << std::left << (" time " + std::to_string(totalSearchTime.count()) + "ms");
     std::cout << std::setw(11) << std::left << (" eval " + evalString) << std::endl;
     std::cout << bestMove.toString() << std::endl;
@@ -193,19 +347,19 @@ void EngineV1_3::inputMove(const StandardMove& move)
             // throw away the previous accumulator
             accumulatorBuffer[0] = accumulatorBuffer[1];
 
-            enginePositionMoves = legalMoves();
+            legalMoves(enginePositionMoves);
 
-            if (positionInfoIndex > 51 || positionInfoIndex == 0) {
-                throw std::runtime_error("Position info index shouldnt be this high/low!!");
+            // Positions before a pawn move or capture can never be repeated, so the state stack is restarted
+            if (!halfMovesSincePawnMoveOrCapture()) {
+                stateStack[0] = *pos.state;
+                pos.state = stateStack.data();
             }
 
-            // Dont reset positionInfo array if move is not a pawn move or capture
-            if (!halfMovesSincePawnMoveOrCapture()) {
-                positionInfo[0] = positionInfo[positionInfoIndex];
-                for (uint8 i = 1; i <= positionInfoIndex; ++i) {
-                    positionInfo[i] = 0;
-                }
-                positionInfoIndex = 0;
+            // Keep room for the states pushed during the search
+            std::size_t stateIndex = pos.state - stateStack.data();
+            if (stateIndex + MAX_DEPTH + 2 > stateStack.size()) {
+                stateStack.resize(stateIndex + MAX_DEPTH + 2);
+                pos.state = stateStack.data() + stateIndex;
             }
             return;
         }
@@ -229,20 +383,20 @@ std::optional<int> EngineV1_3::gameOver() noexcept
 
 bool EngineV1_3::inCheck() const noexcept
 {
-    return inCheck(totalHalfmoves % 2);
+    return inCheck(pos.totalHalfmoves % 2);
 }
 
 std::string EngineV1_3::asFEN() const noexcept
 {
     std::string fen = "";
-    int32 c = totalHalfmoves % 2;
+    int32 c = pos.totalHalfmoves % 2;
 
     // Peice placement data
     char pcs[6] = { 'P', 'N', 'B', 'R', 'Q', 'K' };
     int8 gap = 0;
     for (int8 i = 56; i >= 0; i -= 8) {
         for (int8 j = 0; j < 8; ++j) {
-            if (!peices[i + j]) {
+            if (!pos.peices[i + j]) {
                 ++gap;
                 continue;
             }
@@ -252,7 +406,7 @@ std::string EngineV1_3::asFEN() const noexcept
                 gap = 0;
             }
             // Add peice charecter
-            fen += pcs[(peices[i + j] & 0b111) - 1] + 32 * (peices[i + j] >> 3);
+            fen += pcs[(pos.peices[i + j] & 0b111) - 1] + 32 * (pos.peices[i + j] >> 3);
         }
         // Add gap charecter if needed
         if (gap) {
@@ -270,16 +424,16 @@ std::string EngineV1_3::asFEN() const noexcept
 
     // Castling availiability
     std::string castlingAvailability = "";
-    if (!kingsideCastlingRightsLost[0]) {
+    if (pos.state->castlingRights & KINGSIDE_CASTLING) {
         castlingAvailability += 'K';
     }
-    if (!queensideCastlingRightsLost[0]) {
+    if (pos.state->castlingRights & QUEENSIDE_CASTLING) {
         castlingAvailability += 'Q';
     }
-    if (!kingsideCastlingRightsLost[1]) {
+    if (pos.state->castlingRights & KINGSIDE_CASTLING << 2) {
         castlingAvailability += 'k';
     }
-    if (!queensideCastlingRightsLost[1]) {
+    if (pos.state->castlingRights & QUEENSIDE_CASTLING << 2) {
         castlingAvailability += 'q';
     }
     if (castlingAvailability.size() == 0) {
@@ -302,43 +456,50 @@ std::string EngineV1_3::asFEN() const noexcept
     fen += ' ';
 
     // Total moves
-    fen += std::to_string(totalHalfmoves / 2 + 1);
+    fen += std::to_string(pos.totalHalfmoves / 2 + 1);
 
     return fen;
 }
 
 std::uint64_t EngineV1_3::perft(int depth, bool printOut = false) noexcept
 {
+    // The move stack and state stack only have room for MAX_DEPTH plies
+    depth = std::clamp(depth, 0, MAX_DEPTH);
+
     if (depth == 0) {
         return 1ULL;
     }
 
-    Move moveStack[1500];
+    MoveList<Move, MOVE_STACK_CAPACITY> moveStack;
 
     if (printOut) {
         std::cout << "PERFT TEST\nFEN: " << asFEN() << std::endl;
     }
 
     std::uint64_t nodes = 0;
+    std::vector<std::uint64_t> rootNodes(enginePositionMoves.size(), 0);
 
-    for (size_t i = 0; i < enginePositionMoves.size(); ++i) {
-        std::uint64_t subnodes = 0;
-
-        if (printOut) {
-            std::cout << std::setw(2) << i << " *** " << enginePositionMoves[i].toString() << ": ";
-            std::cout.flush();
-        }
+    // The last ply is left to the tasks so that they can bulk count
+    uint8 splitDepth = static_cast<uint8>(std::min(static_cast<int>(perftSplitDepth), depth - 1));
 
-        if (makeMove(enginePositionMoves[i], 0)) {
-            subnodes = perft_h(1, depth - 1, moveStack, 0);
-            nodes += subnodes;
+    if (perftThreads > 1 && splitDepth > 0) {
+        perft_parallel(depth, splitDepth, rootNodes);
+    }
+    else {
+        for (size_t i = 0; i < enginePositionMoves.size(); ++i) {
+            makeMove(enginePositionMoves[i], 0);
+            rootNodes[i] = perft_h(1, depth - 1, moveStack.data(), 0);
             unmakeMove(enginePositionMoves[i]);
         }
+    }
+
+    // Divide output
+    for (size_t i = 0; i < enginePositionMoves.size(); ++i) {
+        nodes += rootNodes[i];
 
         if (printOut) {
-            std::cout << subnodes << std::endl;
+            std::cout << std::setw(2) << i << " *** " << enginePositionMoves[i].toString() << ": " << rootNodes[i] << std::endl;
         }
-
     }
 
     if (printOut) {
@@ -347,48 +508,87 @@ std::uint64_t EngineV1_3::perft(int depth, bool printOut = false) noexcept
     return nodes;
 }
 
+void EngineV1_3::setPerftThreads(unsigned threads, unsigned splitDepth)
+{
+    perftThreads = std::max(threads, 1U);
+    perftSplitDepth = std::min(splitDepth, static_cast<unsigned>(MAX_PERFT_SPLIT_DEPTH));
+}
+
+void EngineV1_3::setPerftHash(std::size_t megabytes)
+{
+    if (megabytes) {
+        perftTable = std::make_shared<PerftTable>(megabytes);
+    }
+    else {
+        perftTable.reset();
+    }
+}
+
+void EngineV1_3::setSearchThreads(unsigned threads)
+{
+    searchThreads = std::max(threads, 1U);
+}
+
+void EngineV1_3::setSearchHash(std::size_t megabytes)
+{
+    ttable = std::make_shared<TranspositionTable>(megabytes);
+}
+
+void EngineV1_3::clearSearchHash(unsigned threads)
+{
+    ttable->clear(threads);
+}
+
 std::uint64_t EngineV1_3::search_perft(int depth) noexcept
 {
-    Move moveStack[1500];
+    MoveList<Move, MOVE_STACK_CAPACITY> moveStack;
 
     std::cout << "PERFT SEARCH " << asFEN();
     auto start = std::chrono::high_resolution_clock::now();
 
     // Order moves
-    for (Move& move : enginePositionMoves) {
-        MoveOrderer::generateStrengthGuess(this, move);
-    }
-    std::sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](Move& l, Move& r) { return l.strengthGuess > r.strengthGuess; });
+    MoveList<RootMove, MAX_LEGAL_MOVES> moves = rootMoves();
 
-    // Incrementally increase depth until time is up
-    for (int d = 0; d < depth; ++d) {
+    ttable->newSearch();
+
+    SearchHelpers helpers;
+    startSearchHelpers(helpers);
+
+    // Incrementally increase depth (the move stack and killer moves only have room for MAX_DEPTH plies)
+    int maxDepth = std::min(depth, MAX_DEPTH - 1);
+    for (int d = 0; d < maxDepth; ++d) {
         int32 alpha = -MAX_EVAL;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
-        for (Move& move : enginePositionMoves) {
-            move.strengthGuess = -MAX_EVAL;
+        // Erase scores from last iteration (sortByScore will maintain order)
+        for (RootMove& rootMove : moves) {
+            rootMove.score = -MAX_EVAL;
         }
 
         // Run search for each move
-        for (Move& move : enginePositionMoves) {
+        for (RootMove& rootMove : moves) {
 
-            makeMove(move, 0);
-            move.strengthGuess = -search_std(1, d, moveStack, 0, -MAX_EVAL, -alpha);
-            unmakeMove(move);
+            makeMove(rootMove.move, 0);
+            rootMove.score = -search_std(1, d, moveStack.data(), 0, -MAX_EVAL, -alpha);
+            unmakeMove(rootMove.move);
 
-            if (move.strengthGuess > alpha) {
-                alpha = move.strengthGuess;
+            if (rootMove.score > alpha) {
+                alpha = rootMove.score;
             }
 
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
+        moves.sortByScore([](const RootMove& rootMove) { return rootMove.score; });
     }
 
+    stopSearchHelpers(helpers);
+
     auto end = std::chrono::high_resolution_clock::now();
 
-    uint32 nodes = nodesSearchedThisMove;
+    std::uint64_t nodes = nodesSearchedThisMove;
+    for (const HelperResult& result : helpers.results) {
+        nodes += result.nodes;
+    }
     resetSearchMembers();
 
     // Print the total nodes and time
@@ -403,56 +603,63 @@ std::uint64_t EngineV1_3::search_perft(std::chrono::milliseconds thinkTime) noex
     auto endSearch = std::chrono::high_resolution_clock::now() + thinkTime;
     std::chrono::nanoseconds lastSearchDuration(0);
 
-    Move moveStack[1500];
+    MoveList<Move, MOVE_STACK_CAPACITY> moveStack;
 
     std::cout << "PERFT SEARCH " << asFEN();
     auto start = std::chrono::high_resolution_clock::now();
 
     // Order moves
-    for (Move& move : enginePositionMoves) {
-        MoveOrderer::generateStrengthGuess(this, move);
-    }
-    std::sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](Move& l, Move& r) { return l.strengthGuess > r.strengthGuess; });
+    MoveList<RootMove, MAX_LEGAL_MOVES> moves = rootMoves();
+
+    ttable->newSearch();
+
+    SearchHelpers helpers;
+    startSearchHelpers(helpers);
 
     // Incrementally increase depth until time is up
-    for (uint8 depth = 0;; ++depth) {
+    for (uint8 depth = 0; depth < MAX_DEPTH - 1; ++depth) {
         // Calculate the cutoff time to halt search based on last search
         auto searchCutoff = endSearch - lastSearchDuration * 1.25;
         auto start = std::chrono::high_resolution_clock::now();
 
         int32 alpha = -MAX_EVAL;
 
-        // Erase scores from last iteration (stable_sort will maintain order)
-        for (Move& move : enginePositionMoves) {
-            move.strengthGuess = -MAX_EVAL;
+        // Erase scores from last iteration (sortByScore will maintain order)
+        for (RootMove& rootMove : moves) {
+            rootMove.score = -MAX_EVAL;
         }
 
         // Run search for each move
-        for (Move& move : enginePositionMoves) {
+        for (RootMove& rootMove : moves) {
             if (std::chrono::high_resolution_clock::now() > searchCutoff) {
                 break;
             }
 
-            makeMove(move, 0);
-            move.strengthGuess = -search_std(1, depth, moveStack, 0, -MAX_EVAL, -alpha);
-            unmakeMove(move);
+            makeMove(rootMove.move, 0);
+            rootMove.score = -search_std(1, depth, moveStack.data(), 0, -MAX_EVAL, -alpha);
+            unmakeMove(rootMove.move);
 
-            if (move.strengthGuess > alpha) {
-                alpha = move.strengthGuess;
+            if (rootMove.score > alpha) {
+                alpha = rootMove.score;
             }
         }
 
         // Sort moves in order by score
-        std::stable_sort(enginePositionMoves.begin(), enginePositionMoves.end(), [](const Move& l, const Move& r) { return l.strengthGuess > r.strengthGuess; });
+        moves.sortByScore([](const RootMove& rootMove) { return rootMove.score; });
 
         if (std::chrono::high_resolution_clock::now() > searchCutoff) {
             break;
         }
     }
 
+    stopSearchHelpers(helpers);
+
     auto end = std::chrono::high_resolution_clock::now();
 
-    uint32 nodes = nodesSearchedThisMove;
+    std::uint64_t nodes = nodesSearchedThisMove;
+    for (const HelperResult& result : helpers.results) {
+        nodes += result.nodes;
+    }
     resetSearchMembers();
 
     // Print the total nodes and time
@@ -471,86 +678,37 @@ std::int_fast32_t EngineV1_3::testEval()
 // PUBLIC METHODS
 inline uint8 EngineV1_3::Move::start() const noexcept
 {
-    return startSquare;
+    return data & 0b111111;
 }
 
 inline uint8 EngineV1_3::Move::target() const noexcept
 {
-    return targetSquare;
-}
-
-inline uint8 EngineV1_3::Move::moving() const noexcept
-{
-    return movingPeice;
-}
-
-inline uint8 EngineV1_3::Move::captured() const noexcept
-{
-    return capturedPeice;
-}
-
-inline uint8 EngineV1_3::Move::color() const noexcept
-{
-    return (movingPeice >> 3) << 3;
-}
-
-inline uint8 EngineV1_3::Move::enemy() const noexcept
-{
-    return !(movingPeice >> 3) << 3;
+    return (data >> 6) & 0b111111;
 }
 
 inline uint8 EngineV1_3::Move::promotion() const noexcept
 {
-    return flags & PROMOTION;
+    return (data & 0b11 << 14) == PROMOTION ? ((data >> 12) & 0b11) + KNIGHT : 0;
 }
 
 inline bool EngineV1_3::Move::isEnPassant() const noexcept
 {
-    return flags & EN_PASSANT;
+    return (data & 0b11 << 14) == EN_PASSANT;
 }
 
 inline bool EngineV1_3::Move::isCastling() const noexcept
 {
-    return flags & CASTLE;
-}
-
-inline bool EngineV1_3::Move::legalFlagSet() const noexcept
-{
-    return flags & LEGAL;
-}
-
-inline void EngineV1_3::Move::setLegalFlag() noexcept
-{
-    flags |= LEGAL;
-}
-
-inline void EngineV1_3::Move::unSetLegalFlag() noexcept
-{
-    flags |= LEGAL;
-    flags ^= LEGAL;
+    return (data & 0b11 << 14) == CASTLE;
 }
 
-inline int32 EngineV1_3::Move::earlygamePositionalMaterialChange() noexcept
+inline std::uint16_t EngineV1_3::Move::encoded() const noexcept
 {
-    if (!posmatInit) {
-        initializePosmat();
-    }
-    return earlyPosmat;
-}
-
-inline int32 EngineV1_3::Move::endgamePositionalMaterialChange() noexcept
-{
-    if (!posmatInit) {
-        initializePosmat();
-    }
-    return endPosmat;
+    return data;
 }
 
 inline bool EngineV1_3::Move::operator==(const EngineV1_3::Move& other) const
 {
-    return this->start() == other.start()
-        && this->target() == other.target()
-        && this->promotion() == other.promotion();
+    return data == other.data;
 }
 
 inline bool EngineV1_3::Move::operator==(const StandardMove& other) const
@@ -573,104 +731,44 @@ std::string EngineV1_3::Move::toString() const
 }
 
 // CONSTRUCTORS
-EngineV1_3::Move::Move(const EngineV1_3* board, uint8 start, uint8 target, uint8 givenFlags) : startSquare(start), targetSquare(target), flags(givenFlags), strengthGuess(0), posmatInit(false), earlyPosmat(0), endPosmat(0)
-{
-    movingPeice = board->peices[start];
-    capturedPeice = board->peices[target];
-    if (isEnPassant()) {
-        capturedPeice = enemy() + PAWN;
-    }
-}
+EngineV1_3::Move::Move(uint8 start, uint8 target, std::uint16_t type, uint8 promotionPeice)
+    : data(static_cast<std::uint16_t>(start | target << 6 | (type == PROMOTION ? (promotionPeice - KNIGHT) << 12 : 0) | type)) {}
 
-EngineV1_3::Move::Move(const EngineV1_3* board, uint8 start, uint8 target) : startSquare(start), targetSquare(target), flags(NONE), strengthGuess(0), posmatInit(false), earlyPosmat(0), endPosmat(0)
-{
-    movingPeice = board->peices[start];
-    capturedPeice = board->peices[target];
-    if ((movingPeice & 0b111) == PAWN && target == board->eligibleEnpassantSquare()) {
-        flags |= EN_PASSANT;
-        capturedPeice = enemy() + PAWN;
-    }
-    else if ((movingPeice & 0b111) == PAWN && ((target >> 3) == 0 || (target >> 3) == 7)) {
-        flags |= (QUEEN + PROMOTION);
-    }
-    else if ((movingPeice & 0b111) == KING && std::abs(start - target) == 2) {
-        flags |= CASTLE;
-    }
-}
-
-EngineV1_3::Move::Move() : startSquare(0), targetSquare(0), movingPeice(0), capturedPeice(0), flags(0), strengthGuess(0), posmatInit(false), earlyPosmat(0), endPosmat(0) {}
+EngineV1_3::Move::Move() : data(0) {}
+// END MOVE STRUCT
 
-// PRIVATE METHODS
-void EngineV1_3::Move::initializePosmat() noexcept
+// PRIVATE CONSTRUCTOR
+EngineV1_3::EngineV1_3(const EngineV1_3& other)
+    : pos(other.pos), stateStack(other.stateStack), enginePositionMoves(other.enginePositionMoves),
+    perftThreads(1), perftSplitDepth(0), searchThreads(1), stopSearch(nullptr), ttable(other.ttable), perftTable(other.perftTable), nnue(other.nnue)
 {
-    // Update zobrist hash, numpieces and positonal imbalance for moving peice
-    earlyPosmat -= EARLYGAME_PEICE_VALUE[moving()][start()];
-    endPosmat -= ENDGAME_PEICE_VALUE[moving()][start()];
-    if (promotion()) {
-        earlyPosmat += EARLYGAME_PEICE_VALUE[color() + promotion()][target()];
-        endPosmat += ENDGAME_PEICE_VALUE[color() + promotion()][target()];
-    }
-    else {
-        earlyPosmat += EARLYGAME_PEICE_VALUE[moving()][target()];
-        endPosmat += ENDGAME_PEICE_VALUE[moving()][target()];
-    }
-
-
-    // Update zobrist hash and peice indices set for capture
-    if (captured()) {
-        uint8 captureSquare = isEnPassant() ? target() - 8 + 16 * (color() >> 3) : target();
-        earlyPosmat -= EARLYGAME_PEICE_VALUE[captured()][captureSquare];
-        endPosmat -= ENDGAME_PEICE_VALUE[captured()][captureSquare];
-    }
-
-    // Update rooks for castling
-    if (isCastling()) {
-        uint8 rookStart;
-        uint8 rookEnd;
-
-        uint8 castlingRank = target() & 0b11111000;
-        if (target() % 8 < 4) {
-            // Queenside castling
-            rookStart = castlingRank;
-            rookEnd = castlingRank + 3;
-        }
-        else {
-            // Kingside castling
-            rookStart = castlingRank + 7;
-            rookEnd = castlingRank + 5;
-        }
-
-        earlyPosmat -= EARLYGAME_PEICE_VALUE[color() + ROOK][rookStart];
-        endPosmat -= ENDGAME_PEICE_VALUE[color() + ROOK][rookStart];
-        earlyPosmat += EARLYGAME_PEICE_VALUE[color() + ROOK][rookEnd];
-        endPosmat += ENDGAME_PEICE_VALUE[color() + ROOK][rookEnd];
-    }
-    posmatInit = true;
+    // Point the state into the copied stack
+    pos.state = stateStack.data() + (other.pos.state - other.stateStack.data());
+    accumulatorBuffer[0] = other.accumulatorBuffer[0];
+    resetSearchMembers();
 }
-// END MOVE STRUCT
 
 // BOARD METHODS
 void EngineV1_3::initializeFen(const std::string& fenString)
 {
     // Reset current members
-    zobrist = 0;
+    stateStack.assign(MAX_DEPTH + 2, StateInfo());
+    pos.state = stateStack.data();
     for (int i = 0; i < 15; ++i) {
-        numPeices[i] = 0;
+        pos.numPeices[i] = 0;
+        pos.peiceBitboards[i] = 0;
     }
-    numTotalPeices[0] = 0;
-    numTotalPeices[1] = 0;
+    pos.colorBitboards[0] = 0;
+    pos.colorBitboards[1] = 0;
+    pos.numTotalPeices[0] = 0;
+    pos.numTotalPeices[1] = 0;
 
-    material_stage_weight = 0;
-    earlygamePositionalMaterialInbalance = 0;
-    endgamePositionalMaterialInbalance = 0;
+    pos.material_stage_weight = 0;
 
     resetSearchMembers();
 
-    ttable->clear();
-
-    for (uint8 i = 0; i < MAX_DEPTH + 50; ++i) {
-        positionInfo[i] = 0;
-    }
+    // Entries of the last game are left in the table but can no longer be hit
+    ttable->newGame();
 
     std::istringstream fenStringStream(fenString);
     std::string peicePlacementData, activeColor, castlingAvailabilty, enPassantTarget, halfmoveClock, fullmoveNumber;
@@ -692,28 +790,28 @@ void EngineV1_3::initializeFen(const std::string& fenString)
             switch (peiceInfo) {
             case 'P':
             case 'p':
-                peices[peiceIndex++] = color + PAWN;
+                pos.peices[peiceIndex++] = color + PAWN;
                 break;
             case 'N':
             case 'n':
-                peices[peiceIndex++] = color + KNIGHT;
+                pos.peices[peiceIndex++] = color + KNIGHT;
                 break;
             case 'B':
             case 'b':
-                peices[peiceIndex++] = color + BISHOP;
+                pos.peices[peiceIndex++] = color + BISHOP;
                 break;
             case 'R':
             case 'r':
-                peices[peiceIndex++] = color + ROOK;
+                pos.peices[peiceIndex++] = color + ROOK;
                 break;
             case 'Q':
             case 'q':
-                peices[peiceIndex++] = color + QUEEN;
+                pos.peices[peiceIndex++] = color + QUEEN;
                 break;
             case 'K':
             case 'k':
-                kingIndex[color >> 3] = peiceIndex;
-                peices[peiceIndex++] = color + KING;
+                pos.kingIndex[color >> 3] = peiceIndex;
+                pos.peices[peiceIndex++] = color + KING;
                 break;
             default:
                 throw std::invalid_argument("Unrecognised alpha char in FEN peice placement data!");
@@ -724,7 +822,7 @@ void EngineV1_3::initializeFen(const std::string& fenString)
             // char contains data about gaps between peices
             uint8 gap = peiceInfo - '0';
             for (uint8 i = 0; i < gap; ++i) {
-                peices[peiceIndex++] = 0;
+                pos.peices[peiceIndex++] = 0;
             }
 
         }
@@ -751,13 +849,13 @@ void EngineV1_3::initializeFen(const std::string& fenString)
 
     if (activeColor == "w") {
         // White is to move
-        totalHalfmoves = 0;
+        pos.totalHalfmoves = 0;
 
     }
     else if (activeColor == "b") {
         // Black is to move
-        totalHalfmoves = 1;
-        zobrist ^= ZOBRIST_TURN_KEY;
+        pos.totalHalfmoves = 1;
+        pos.state->zobrist ^= ZOBRIST_TURN_KEY;
 
     }
     else {
@@ -771,11 +869,6 @@ void EngineV1_3::initializeFen(const std::string& fenString)
     }
 
     // Update castling availibility according to fen rules
-    kingsideCastlingRightsLost[0] = -1;
-    kingsideCastlingRightsLost[1] = -1;
-    queensideCastlingRightsLost[0] = -1;
-    queensideCastlingRightsLost[1] = -1;
-
     if (castlingAvailabilty != "-") {
         for (char castlingInfo : castlingAvailabilty) {
             //int32 color = std::islower(c);
@@ -785,16 +878,16 @@ void EngineV1_3::initializeFen(const std::string& fenString)
             switch (castlingInfo) {
             case 'K':
             case 'k':
-                if (peices[castlingRank + 4] == color + KING && peices[castlingRank + 7] == color + ROOK) {
-                    kingsideCastlingRightsLost[c] = 0;
-                    zobrist ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[c];
+                if (pos.peices[castlingRank + 4] == color + KING && pos.peices[castlingRank + 7] == color + ROOK) {
+                    pos.state->castlingRights |= KINGSIDE_CASTLING << 2 * c;
+                    pos.state->zobrist ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[c];
                 }
                 break;
             case 'Q':
             case 'q':
-                if (peices[castlingRank + 4] == color + KING && peices[castlingRank] == color + ROOK) {
-                    queensideCastlingRightsLost[c] = 0;
-                    zobrist ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[c];
+                if (pos.peices[castlingRank + 4] == color + KING && pos.peices[castlingRank] == color + ROOK) {
+                    pos.state->castlingRights |= QUEENSIDE_CASTLING << 2 * c;
+                    pos.state->zobrist ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[c];
                 }
                 break;
             default:
@@ -815,17 +908,15 @@ void EngineV1_3::initializeFen(const std::string& fenString)
     }
 
     try {
-        positionInfoIndex = static_cast<uint8>(std::stoi(halfmoveClock));
-        positionInfo[positionInfoIndex] |= static_cast<uint32>(positionInfoIndex) << 20;
+        pos.state->halfmovesSincePawnMoveOrCapture = static_cast<uint8>(std::stoi(halfmoveClock));
     }
     catch (const std::invalid_argument& e) {
         throw std::invalid_argument(std::string("Invalid FEN half move clock! ") + e.what());
     }
 
-    // wait until halfmove clock are defined before defining
     if (enPassantTarget != "-") {
         try {
-            positionInfo[positionInfoIndex] |= static_cast<uint32>(chesshelpers::algebraicNotationToBoardIndex(enPassantTarget)) << 26;
+            pos.state->enPassantSquare = static_cast<uint8>(chesshelpers::algebraicNotationToBoardIndex(enPassantTarget));
         }
         catch (const std::invalid_argument& e) {
             throw std::invalid_argument(std::string("Invalid FEN en passant target! ") + e.what());
@@ -840,7 +931,7 @@ void EngineV1_3::initializeFen(const std::string& fenString)
     }
 
     try {
-        totalHalfmoves += static_cast<uint32>(std::stoi(fullmoveNumber) * 2 - 2);
+        pos.totalHalfmoves += static_cast<uint32>(std::stoi(fullmoveNumber) * 2 - 2);
     }
     catch (const std::invalid_argument& e) {
         throw std::invalid_argument(std::string("Invalid FEN full move number! ") + e.what());
@@ -850,915 +941,516 @@ void EngineV1_3::initializeFen(const std::string& fenString)
 
     // initialize zobrist hash for all of the peices
     for (uint8 i = 0; i < 64; ++i) {
-        uint8 peice = peices[i];
+        uint8 peice = pos.peices[i];
         if (peice) {
-            zobrist ^= ZOBRIST_PEICE_KEYS[peice >> 3][(peice & 0b111) - 1][i];
-            ++numPeices[peice];
-            ++numTotalPeices[peice >> 3];
-            material_stage_weight += PEICE_STAGE_WEIGHTS[peice];
-            earlygamePositionalMaterialInbalance += EARLYGAME_PEICE_VALUE[peice][i];
-            endgamePositionalMaterialInbalance += ENDGAME_PEICE_VALUE[peice][i];
+            pos.state->zobrist ^= ZOBRIST_PEICE_KEYS[peice >> 3][(peice & 0b111) - 1][i];
+            ++pos.numPeices[peice];
+            ++pos.numTotalPeices[peice >> 3];
+            pos.peiceBitboards[peice] |= bitboards::bit(i);
+            pos.colorBitboards[peice >> 3] |= bitboards::bit(i);
+            pos.material_stage_weight += PEICE_STAGE_WEIGHTS[peice];
+            pos.state->earlygamePositionalMaterialInbalance += EARLYGAME_PEICE_VALUE[peice][i];
+            pos.state->endgamePositionalMaterialInbalance += ENDGAME_PEICE_VALUE[peice][i];
             activeFeatures.push_back((2 * ((peice & 0b111) - 1) + (peice >> 3)) * 64 + i);
         }
     }
 
     nnue.refreshAccumulator(accumulatorBuffer[0], activeFeatures);
 
-    positionInfo[positionInfoIndex] |= zobrist >> 44;
+    uint8 c = pos.totalHalfmoves % 2;
 
-    uint8 c = totalHalfmoves % 2;
+    legalMoves(enginePositionMoves);
+}
 
-    enginePositionMoves = legalMoves();
+bool EngineV1_3::generateLegalMoves(Move* stack, uint32& idx, uint8 moveTypes, uint64 startSquares) noexcept
+{
+    return pos.totalHalfmoves % 2 ? generateLegalMoves<BLACK>(stack, idx, moveTypes, startSquares) : generateLegalMoves<WHITE>(stack, idx, moveTypes, startSquares);
 }
 
-bool EngineV1_3::generatePseudoLegalMoves(Move* stack, uint32& idx, bool generateOnlyCaptures) noexcept
+template <std::uint_fast8_t color>
+bool EngineV1_3::generateLegalMoves(Move* stack, uint32& idx, uint8 moveTypes, uint64 startSquares) noexcept
 {
-    // TODO Backwards check/pin generation for endgame
-    // TODO Better pinned peice generation (detect if sliding along diagonal of pin)
+    constexpr uint8 c = color >> 3;
+    constexpr uint8 e = !c;
+    constexpr uint8 enemy = e << 3;
 
-    uint8 c = totalHalfmoves % 2;
-    uint8 color = c << 3;
-    uint8 e = !color;
-    uint8 enemy = e << 3;
+    // Pawn direction and ranks of the side to move
+    constexpr int8 forward = c ? -8 : 8;
+    constexpr uint64 doublePushRank = c ? bitboards::RANK_6 : bitboards::RANK_3;
+    constexpr uint8 castlingRank = 56 * c;
 
-    // Used for optimizing the legality checking of moves
-    bool isPinned[64] = { 0 };
-    std::unordered_set<uint8> checkingSquares(11);
+    uint64 friendly = pos.colorBitboards[c];
+    uint64 enemies = pos.colorBitboards[e];
+    uint64 occupied = friendly | enemies;
+    uint8 king = pos.kingIndex[c];
 
-    // Check if king in check and record pinned peices and checking squares
-    uint8 king = kingIndex[c];
-    uint8 checks = 0;
+    // Check if king in check and record pinned peices
+    uint64 checkers = attackersTo(king, occupied) & enemies;
+    uint64 pinned = pinnedPeices(c);
+    int checks = bitboards::popcount(checkers);
 
-    // Pawn checks
-    if (numPeices[enemy + PAWN]) {
-        uint8 kingFile = king % 8;
-        uint8 kingAhead = king + 8 - 16 * c;
-        if (kingFile != 0 && peices[kingAhead - 1] == enemy + PAWN) {
-            checkingSquares.insert(kingAhead - 1);
-            ++checks;
-        }
-        if (kingFile != 7 && peices[kingAhead + 1] == enemy + PAWN) {
-            checkingSquares.insert(kingAhead + 1);
-            ++checks;
-        }
+    // Quiet moves are still needed to get out of check
+    if (checks) {
+        moveTypes = ALL_MOVES;
     }
 
-    // Knight checks
-    if (numPeices[enemy + KNIGHT]) {
-        for (uint8 j = 1; j < KNIGHT_MOVES[king][0]; ++j) {
-            if (peices[KNIGHT_MOVES[king][j]] == enemy + KNIGHT) {
-                checkingSquares.insert(KNIGHT_MOVES[king][j]);
-                ++checks;
-            }
+    // Squares that can be moved to for the requested move types
+    uint64 typeTargets = (moveTypes & CAPTURES ? enemies : 0) | (moveTypes & QUIETS ? ~occupied : 0);
+
+    // Generate king moves (king is removed from the board so it cant hide behind itself from a slider)
+    uint64 kingTargets = startSquares & bitboards::bit(king) ? bitboards::KING_ATTACKS[king] & typeTargets : 0;
+    uint64 occupiedWithoutKing = occupied ^ bitboards::bit(king);
+    while (kingTargets) {
+        uint8 t = bitboards::popLsb(kingTargets);
+        if (!(attackersTo(t, occupiedWithoutKing) & enemies)) {
+            stack[idx++] = Move(king, t);
         }
     }
 
-    // pins and sliding peice checks
-    uint8 potentialPin = 0;
-    // Dont bother checking horizontals if no bishops or queens
-    if (numPeices[enemy + ROOK] | numPeices[enemy + QUEEN]) {
-        for (int8 j = king - 8; j >= DIRECTION_BOUNDS[king][B]; j -= 8) {
-            if (!peices[j]) {
-                continue;
-            }
-            if (!potentialPin && peices[j] >> 3 == c) {
-                potentialPin = j;
-                continue;
-            }
-            if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                if (potentialPin) {
-                    isPinned[potentialPin] = true;
-                    break;
-                }
-                if (checks++) { // dont need to record checking squares/pins for double checks
-                    goto moveGeneration;
-                }
-                for (int8 k = j; k < king; k += 8) {
-                    checkingSquares.insert(k);
-                }
+    // Double check; Only king moves are legal
+    if (checks > 1) {
+        return true;
+    }
+
+    // Squares any other peice is allowed to move to (only the checking peice and the squares between it and the king when in check)
+    uint64 evasionTargets = checks ? checkers | bitboards::BETWEEN[king][bitboards::lsb(checkers)] : ~friendly;
+    uint64 targets = evasionTargets & typeTargets;
+
+    // Pawn moves (promotions are generated with the captures)
+    uint64 pawns = pos.peiceBitboards[color + PAWN] & startSquares;
+    uint64 promotionRanks = bitboards::RANK_1 | bitboards::RANK_8;
+    uint64 singlePushes = shifted<forward>(pawns) & ~occupied;
+    uint64 doublePushes = moveTypes & QUIETS ? shifted<forward>(singlePushes & doublePushRank) & ~occupied & evasionTargets : 0;
+    singlePushes &= evasionTargets;
+    if (!(moveTypes & QUIETS)) {
+        singlePushes &= promotionRanks;
+    }
+    if (!(moveTypes & CAPTURES)) {
+        singlePushes &= ~promotionRanks;
+    }
+
+    while (singlePushes) {
+        uint8 t = bitboards::popLsb(singlePushes);
+        addPawnMoves<color>(stack, idx, t - forward, t, pinned);
+    }
+    while (doublePushes) {
+        uint8 t = bitboards::popLsb(doublePushes);
+        addPawnMoves<color>(stack, idx, t - 2 * forward, t, pinned);
+    }
+
+    uint64 pawnCaptureTargets = moveTypes & CAPTURES ? enemies & evasionTargets : 0;
+    uint64 leftCaptures = shifted<forward - 1>(pawns & ~bitboards::FILE_A) & pawnCaptureTargets;
+    uint64 rightCaptures = shifted<forward + 1>(pawns & ~bitboards::FILE_H) & pawnCaptureTargets;
+    while (leftCaptures) {
+        uint8 t = bitboards::popLsb(leftCaptures);
+        addPawnMoves<color>(stack, idx, t - (forward - 1), t, pinned);
+    }
+    while (rightCaptures) {
+        uint8 t = bitboards::popLsb(rightCaptures);
+        addPawnMoves<color>(stack, idx, t - (forward + 1), t, pinned);
+    }
+
+    // En passant moves (captured pawn must be the checking peice, or the en passant square must block the check)
+    uint8 epSquare = eligibleEnpassantSquare();
+    uint8 epCaptureSquare = epSquare - forward;
+    if (epSquare && moveTypes & CAPTURES && (!checks || (checkers & bitboards::bit(epCaptureSquare)) || (evasionTargets & bitboards::bit(epSquare)))) {
+        uint64 diagonalEnemies = pos.peiceBitboards[enemy + BISHOP] | pos.peiceBitboards[enemy + QUEEN];
+        uint64 orthogonalEnemies = pos.peiceBitboards[enemy + ROOK] | pos.peiceBitboards[enemy + QUEEN];
+        uint64 epAttackers = bitboards::PAWN_ATTACKS[e][epSquare] & pawns;
+        while (epAttackers) {
+            uint8 s = bitboards::popLsb(epAttackers);
+            // Both pawns leave their squares, which can expose the king along the rank (pins on the capturing pawn are also caught here)
+            uint64 occupiedAfter = (occupied ^ bitboards::bit(s) ^ bitboards::bit(epCaptureSquare)) | bitboards::bit(epSquare);
+            if (!(bitboards::rookAttacks(king, occupiedAfter) & orthogonalEnemies) && !(bitboards::bishopAttacks(king, occupiedAfter) & diagonalEnemies)) {
+                stack[idx++] = Move(s, epSquare, Move::EN_PASSANT);
             }
-            break;
         }
+    }
 
-        potentialPin = 0;
-        for (int8 j = king + 8; j <= DIRECTION_BOUNDS[king][F]; j += 8) {
-            if (!peices[j]) {
-                continue;
-            }
-            if (!potentialPin && peices[j] >> 3 == c) {
-                potentialPin = j;
-                continue;
-            }
-            if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                if (potentialPin) {
-                    isPinned[potentialPin] = true;
-                    break;
-                }
-                if (checks++) { // dont need to record checking squares/pins for double checks
-                    goto moveGeneration;
-                }
-                for (int8 k = j; k > king; k -= 8) {
-                    checkingSquares.insert(k);
-                }
-            }
-            break;
+    // Castling (king must not pass through or land on an attacked square)
+    if (moveTypes & QUIETS && !checks && startSquares & bitboards::bit(king)) {
+        if (pos.state->castlingRights & KINGSIDE_CASTLING << 2 * c && !(occupied & (0b01100000ULL << castlingRank))
+            && !(attackersTo(castlingRank + 5, occupied) & enemies) && !(attackersTo(castlingRank + 6, occupied) & enemies)) {
+            stack[idx++] = Move(castlingRank + 4, castlingRank + 6, Move::CASTLE);
+        }
+        if (pos.state->castlingRights & QUEENSIDE_CASTLING << 2 * c && !(occupied & (0b00001110ULL << castlingRank))
+            && !(attackersTo(castlingRank + 3, occupied) & enemies) && !(attackersTo(castlingRank + 2, occupied) & enemies)) {
+            stack[idx++] = Move(castlingRank + 4, castlingRank + 2, Move::CASTLE);
         }
+    }
 
-        potentialPin = 0;
-        for (int8 j = king - 1; j >= DIRECTION_BOUNDS[king][L]; j -= 1) {
-            if (!peices[j]) {
-                continue;
-            }
-            if (!potentialPin && peices[j] >> 3 == c) {
-                potentialPin = j;
-                continue;
-            }
-            if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                if (potentialPin) {
-                    isPinned[potentialPin] = true;
-                    break;
-                }
-                if (checks++) { // dont need to record checking squares/pins for double checks
-                    goto moveGeneration;
-                }
-                for (int8 k = j; k < king; k += 1) {
-                    checkingSquares.insert(k);
-                }
-            }
-            break;
+    // Knight moves (pinned knights can never move)
+    uint64 knights = pos.peiceBitboards[color + KNIGHT] & ~pinned & startSquares;
+    while (knights) {
+        uint8 s = bitboards::popLsb(knights);
+        uint64 attacks = bitboards::KNIGHT_ATTACKS[s] & targets;
+        while (attacks) {
+            stack[idx++] = Move(s, bitboards::popLsb(attacks));
         }
+    }
 
-        potentialPin = 0;
-        for (int8 j = king + 1; j <= DIRECTION_BOUNDS[king][R]; j += 1) {
-            if (!peices[j]) {
-                continue;
-            }
-            if (!potentialPin && peices[j] >> 3 == c) {
-                potentialPin = j;
-                continue;
-            }
-            if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                if (potentialPin) {
-                    isPinned[potentialPin] = true;
-                    break;
-                }
-                if (checks++) { // dont need to record checking squares/pins for double checks
-                    goto moveGeneration;
-                }
-                for (int8 k = j; k > king; k -= 1) {
-                    checkingSquares.insert(k);
-                }
-            }
-            break;
+    // Sliding moves (pinned sliders can only move along the line through their king)
+    uint64 diagonalSliders = (pos.peiceBitboards[color + BISHOP] | pos.peiceBitboards[color + QUEEN]) & startSquares;
+    while (diagonalSliders) {
+        uint8 s = bitboards::popLsb(diagonalSliders);
+        uint64 attacks = bitboards::bishopAttacks(s, occupied) & targets;
+        if (pinned & bitboards::bit(s)) {
+            attacks &= bitboards::LINE[king][s];
+        }
+        while (attacks) {
+            stack[idx++] = Move(s, bitboards::popLsb(attacks));
         }
     }
 
-    // Dont bother checking diagonals if no bishops or queens
-    if (numPeices[enemy + BISHOP] | numPeices[enemy + QUEEN]) {
-        potentialPin = 0;
-        for (int8 j = king - 9; j >= DIRECTION_BOUNDS[king][BL]; j -= 9) {
-            if (!peices[j]) {
-                continue;
-            }
-            if (!potentialPin && peices[j] >> 3 == c) {
-                potentialPin = j;
-                continue;
-            }
-            if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                if (potentialPin) {
-                    isPinned[potentialPin] = true;
-                    break;
-                }
-                if (checks++) { // dont need to record checking squares/pins for double checks
-                    goto moveGeneration;
-                }
-                for (int8 k = j; k < king; k += 9) {
-                    checkingSquares.insert(k);
-                }
-            }
-            break;
+    uint64 orthogonalSliders = (pos.peiceBitboards[color + ROOK] | pos.peiceBitboards[color + QUEEN]) & startSquares;
+    while (orthogonalSliders) {
+        uint8 s = bitboards::popLsb(orthogonalSliders);
+        uint64 attacks = bitboards::rookAttacks(s, occupied) & targets;
+        if (pinned & bitboards::bit(s)) {
+            attacks &= bitboards::LINE[king][s];
         }
+        while (attacks) {
+            stack[idx++] = Move(s, bitboards::popLsb(attacks));
+        }
+    }
 
-        potentialPin = 0;
-        for (int8 j = king + 9; j <= DIRECTION_BOUNDS[king][FR]; j += 9) {
-            if (!peices[j]) {
-                continue;
-            }
-            if (!potentialPin && peices[j] >> 3 == c) {
-                potentialPin = j;
-                continue;
-            }
-            if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                if (potentialPin) {
-                    isPinned[potentialPin] = true;
-                    break;
-                }
-                if (checks++) { // dont need to record checking squares/pins for double checks
-                    goto moveGeneration;
-                }
-                for (int8 k = j; k > king; k -= 9) {
-                    checkingSquares.insert(k);
-                }
-            }
-            break;
-        }
+    return checks;
+}
 
-        potentialPin = 0;
-        for (int8 j = king - 7; j >= DIRECTION_BOUNDS[king][BR]; j -= 7) {
-            if (!peices[j]) {
-                continue;
-            }
-            if (!potentialPin && peices[j] >> 3 == c) {
-                potentialPin = j;
-                continue;
-            }
-            if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                if (potentialPin) {
-                    isPinned[potentialPin] = true;
-                    break;
-                }
-                if (checks++) { // dont need to record checking squares/pins for double checks
-                    goto moveGeneration;
-                }
-                for (int8 k = j; k < king; k += 7) {
-                    checkingSquares.insert(k);
-                }
-            }
-            break;
-        }
+template <std::uint_fast8_t color>
+void EngineV1_3::addPawnMoves(Move* stack, uint32& idx, uint8 start, uint8 target, uint64 pinned) const noexcept
+{
+    constexpr uint8 promotionRank = color ? 0 : 7;
 
-        potentialPin = 0;
-        for (int8 j = king + 7; j <= DIRECTION_BOUNDS[king][FL]; j += 7) {
-            if (!peices[j]) {
-                continue;
-            }
-            if (!potentialPin && peices[j] >> 3 == c) {
-                potentialPin = j;
-                continue;
-            }
-            if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                if (potentialPin) {
-                    isPinned[potentialPin] = true;
-                    break;
-                }
-                if (checks++) { // dont need to record checking squares/pins for double checks
-                    goto moveGeneration;
-                }
-                for (int8 k = j; k > king; k -= 7) {
-                    checkingSquares.insert(k);
-                }
-            }
-            break;
-        }
+    // Pinned pawns can only move along the line through their king
+    if ((pinned & bitboards::bit(start)) && !(bitboards::LINE[pos.kingIndex[color >> 3]][start] & bitboards::bit(target))) {
+        return;
     }
 
-moveGeneration:
-    // Double check; Only king moves are legal
-    if (checks > 1) {
-        // Generate king moves
-        for (uint8 j = 1; j < KING_MOVES[king][0]; ++j) {
-            if ((!peices[KING_MOVES[king][j]] && !checkingSquares.count(KING_MOVES[king][j])) || peices[KING_MOVES[king][j]] >> 3 == e) {
-                stack[idx++] = Move(this, king, KING_MOVES[king][j], Move::NONE);
-            }
-        }
-        return true;
+    if ((target >> 3) == promotionRank) {
+        stack[idx++] = Move(start, target, Move::PROMOTION, KNIGHT);
+        stack[idx++] = Move(start, target, Move::PROMOTION, BISHOP);
+        stack[idx++] = Move(start, target, Move::PROMOTION, ROOK);
+        stack[idx++] = Move(start, target, Move::PROMOTION, QUEEN);
     }
+    else {
+        stack[idx++] = Move(start, target);
+    }
+}
 
-    // En passant moves
-    uint8 epSquare = eligibleEnpassantSquare();
-    if (epSquare) {
-        uint8 epfile = epSquare % 8;
-        if (color == WHITE) {
-            if (epfile != 0 && peices[epSquare - 9] == color + PAWN && (!checks || checkingSquares.count(epSquare - 8))) {
-                stack[idx++] = Move(this, epSquare - 9, epSquare, Move::EN_PASSANT);
-            }
-            if (epfile != 7 && peices[epSquare - 7] == color + PAWN && (!checks || checkingSquares.count(epSquare - 8))) {
-                stack[idx++] = Move(this, epSquare - 7, epSquare, Move::EN_PASSANT);
-            }
-        }
-        else {
-            if (epfile != 0 && peices[epSquare + 7] == color + PAWN && (!checks || checkingSquares.count(epSquare + 8))) {
-                stack[idx++] = Move(this, epSquare + 7, epSquare, Move::EN_PASSANT);
-            }
-            if (epfile != 7 && peices[epSquare + 9] == color + PAWN && (!checks || checkingSquares.count(epSquare + 8))) {
-                stack[idx++] = Move(this, epSquare + 9, epSquare, Move::EN_PASSANT);
-            }
-        }
-    }
-
-    // Special move generation for when few number of checking squares
-    if (checks && checkingSquares.size() < 4) {
-        // Generate king moves
-        for (uint8 j = 1; j < KING_MOVES[king][0]; ++j) {
-            if ((!peices[KING_MOVES[king][j]] && !checkingSquares.count(KING_MOVES[king][j])) || peices[KING_MOVES[king][j]] >> 3 == e) {
-                stack[idx++] = Move(this, king, KING_MOVES[king][j], Move::NONE);
-            }
-        }
-
-        // Backwards search from checking squares to see if peices can move to them
-        for (uint8 t : checkingSquares) {
-
-            // Pawn can block/take
-            if (numPeices[color + PAWN]) {
-                if ((color == WHITE && t >> 3 >= 2) || (color == BLACK && t >> 3 <= 5)) {
-                    uint8 file = t % 8;
-                    uint8 ahead = t - 8 + 16 * c;
-                    bool promotion = (t >> 3) == 0 || (t >> 3) == 7;
-                    // Pawn capture
-                    if (peices[t] && peices[t] >> 3 == e) {
-                        if (file != 0 && peices[ahead - 1] == color + PAWN && !isPinned[ahead - 1]) {
-                            if (promotion) {
-                                stack[idx++] = Move(this, ahead - 1, t, KNIGHT | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead - 1, t, BISHOP | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead - 1, t, ROOK | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead - 1, t, QUEEN | Move::LEGAL);
-                            }
-                            else {
-                                stack[idx++] = Move(this, ahead - 1, t, Move::LEGAL);
-                            }
-                        }
-                        if (file != 7 && peices[ahead + 1] == color + PAWN && !isPinned[ahead + 1]) {
-                            if (promotion) {
-                                stack[idx++] = Move(this, ahead + 1, t, KNIGHT | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead + 1, t, BISHOP | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead + 1, t, ROOK | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead + 1, t, QUEEN | Move::LEGAL);
-                            }
-                            else {
-                                stack[idx++] = Move(this, ahead + 1, t, Move::LEGAL);
-                            }
-                        }
-                        // Pawn move
-                    }
-                    else if (!peices[t]) {
-                        int8 doubleAhead = ahead - 8 + 16 * c;
-                        if (peices[ahead] == color + PAWN && !isPinned[ahead]) {
-                            if (promotion) {
-                                stack[idx++] = Move(this, ahead, t, KNIGHT | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead, t, BISHOP | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead, t, ROOK | Move::LEGAL);
-                                stack[idx++] = Move(this, ahead, t, QUEEN | Move::LEGAL);
-                            }
-                            else {
-                                stack[idx++] = Move(this, ahead, t, Move::LEGAL);
-                            }
-
-                        }
-                        else if ((doubleAhead >> 3 == 1 || doubleAhead >> 3 == 6) && !peices[ahead] && peices[doubleAhead] == color + PAWN && !isPinned[doubleAhead]) {
-                            stack[idx++] = Move(this, doubleAhead, t, Move::LEGAL);
-                        }
-                    }
-                }
-            }
-
-            // Knight can block/take
-            if (numPeices[color + KNIGHT]) {
-                for (uint8 j = 1; j < KNIGHT_MOVES[t][0]; ++j) {
-                    if (peices[KNIGHT_MOVES[t][j]] == color + KNIGHT && !isPinned[KNIGHT_MOVES[t][j]]) {
-                        stack[idx++] = Move(this, KNIGHT_MOVES[t][j], t, Move::LEGAL);
-                    }
-                }
-            }
-
-            // Sliding peices can block/take
-            if (numPeices[color + ROOK] | numPeices[color + QUEEN]) {
-                for (int8 s = t - 8; s >= DIRECTION_BOUNDS[t][B]; s -= 8) {
-                    if (peices[s]) {
-                        if ((peices[s] == color + ROOK || peices[s] == color + QUEEN) && !isPinned[s]) {
-                            stack[idx++] = Move(this, s, t, Move::LEGAL);
-                        }
-                        break;
-                    }
-                }
-
-                for (int8 s = t + 8; s <= DIRECTION_BOUNDS[t][F]; s += 8) {
-                    if (peices[s]) {
-                        if ((peices[s] == color + ROOK || peices[s] == color + QUEEN) && !isPinned[s]) {
-                            stack[idx++] = Move(this, s, t, Move::LEGAL);
-                        }
-                        break;
-                    }
-                }
-
-                for (int8 s = t - 1; s >= DIRECTION_BOUNDS[t][L]; s -= 1) {
-                    if (peices[s]) {
-                        if ((peices[s] == color + ROOK || peices[s] == color + QUEEN) && !isPinned[s]) {
-                            stack[idx++] = Move(this, s, t, Move::LEGAL);
-                        }
-                        break;
-                    }
-                }
-
-                for (int8 s = t + 1; s <= DIRECTION_BOUNDS[t][R]; s += 1) {
-                    if (peices[s]) {
-                        if ((peices[s] == color + ROOK || peices[s] == color + QUEEN) && !isPinned[s]) {
-                            stack[idx++] = Move(this, s, t, Move::LEGAL);
-                        }
-                        break;
-                    }
-                }
-            }
-
-            if (numPeices[color + BISHOP] | numPeices[color + QUEEN]) {
-                for (int8 s = t - 9; s >= DIRECTION_BOUNDS[t][BL]; s -= 9) {
-                    if (peices[s]) {
-                        if ((peices[s] == color + BISHOP || peices[s] == color + QUEEN) && !isPinned[s]) {
-                            stack[idx++] = Move(this, s, t, Move::LEGAL);
-                        }
-                        break;
-                    }
-                }
+void EngineV1_3::legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves)
+{
+    uint32 end = 0;
+    generateLegalMoves(moves.data(), end);
+    moves.resize(end);
+}
 
-                for (int8 s = t + 9; s <= DIRECTION_BOUNDS[t][FR]; s += 9) {
-                    if (peices[s]) {
-                        if ((peices[s] == color + BISHOP || peices[s] == color + QUEEN) && !isPinned[s]) {
-                            stack[idx++] = Move(this, s, t, Move::LEGAL);
-                        }
-                        break;
-                    }
-                }
+MoveList<EngineV1_3::RootMove, EngineV1_3::MAX_LEGAL_MOVES> EngineV1_3::rootMoves()
+{
+    MoveList<RootMove, MAX_LEGAL_MOVES> moves;
+    for (Move move : enginePositionMoves) {
+        moves.push_back({ move, MoveOrderer::generateStrengthGuess(this, move) });
+    }
+    moves.sortByScore([](const RootMove& rootMove) { return rootMove.score; });
+    return moves;
+}
 
-                for (int8 s = t - 7; s >= DIRECTION_BOUNDS[t][BR]; s -= 7) {
-                    if (peices[s]) {
-                        if ((peices[s] == color + BISHOP || peices[s] == color + QUEEN) && !isPinned[s]) {
-                            stack[idx++] = Move(this, s, t, Move::LEGAL);
-                        }
-                        break;
-                    }
-                }
+inline uint8 EngineV1_3::movingPeice(Move move) const noexcept
+{
+    return pos.peices[move.start()];
+}
 
-                for (int8 s = t + 7; s <= DIRECTION_BOUNDS[t][FL]; s += 7) {
-                    if (peices[s]) {
-                        if ((peices[s] == color + BISHOP || peices[s] == color + QUEEN) && !isPinned[s]) {
-                            stack[idx++] = Move(this, s, t, Move::LEGAL);
-                        }
-                        break;
-                    }
-                }
-            }
-        }
-        return true;
+inline uint8 EngineV1_3::capturedPeice(Move move) const noexcept
+{
+    if (move.isEnPassant()) {
+        return (!(pos.peices[move.start()] >> 3) << 3) + PAWN;
     }
+    return pos.peices[move.target()];
+}
 
-    if (!checks && generateOnlyCaptures) {
-        generateCaptures(stack, idx, isPinned);
-        return false;
-    }
+void EngineV1_3::positionalMaterialChange(Move move, int32& earlygameChange, int32& endgameChange) const noexcept
+{
+    uint8 moving = movingPeice(move);
+    uint8 captured = capturedPeice(move);
+    uint8 color = moving & 0b1000;
 
-    // Castling
-    if (!kingsideCastlingRightsLost[c] && !checks) {
-        uint8 castlingRank = 56 * c;
-        bool roomToCastle = true;
-        for (uint8 j = castlingRank + 5; j < castlingRank + 7; ++j) {
-            if (peices[j]) {
-                roomToCastle = false;
-                break;
-            }
-        }
-        if (roomToCastle) {
-            stack[idx++] = Move(this, castlingRank + 4, castlingRank + 6, Move::CASTLE);
-        }
+    // Moving peice leaves the start square (and may be promoted on the target square)
+    earlygameChange = -EARLYGAME_PEICE_VALUE[moving][move.start()];
+    endgameChange = -ENDGAME_PEICE_VALUE[moving][move.start()];
+    if (move.promotion()) {
+        earlygameChange += EARLYGAME_PEICE_VALUE[color + move.promotion()][move.target()];
+        endgameChange += ENDGAME_PEICE_VALUE[color + move.promotion()][move.target()];
     }
-    if (!queensideCastlingRightsLost[c] && !checks) {
-        uint8 castlingRank = 56 * c;
-        bool roomToCastle = true;
-        for (uint8 j = castlingRank + 3; j > castlingRank; --j) {
-            if (peices[j]) {
-                roomToCastle = false;
-                break;
-            }
-        }
-        if (roomToCastle) {
-            stack[idx++] = Move(this, castlingRank + 4, castlingRank + 2, Move::CASTLE);
-        }
+    else {
+        earlygameChange += EARLYGAME_PEICE_VALUE[moving][move.target()];
+        endgameChange += ENDGAME_PEICE_VALUE[moving][move.target()];
     }
 
-    // General case
-    for (uint8 s = 0; s < 64; ++s) {
-        if (peices[s] && peices[s] >> 3 == c) {
-            uint8 legalFlag = isPinned[s] ? Move::NONE : Move::LEGAL;
-
-            switch (peices[s] & 0b111) {
-            case PAWN: {
-                uint8 file = s % 8;
-                uint8 ahead = s + 8 - 16 * c;
-                bool promotion = color == WHITE ? (s >> 3 == 6) : (s >> 3 == 1);
-
-                // Pawn foward moves
-                if (!peices[ahead]) {
-                    if (!checks || checkingSquares.count(ahead)) {
-                        if (promotion) {
-                            stack[idx++] = Move(this, s, ahead, legalFlag | KNIGHT);
-                            stack[idx++] = Move(this, s, ahead, legalFlag | BISHOP);
-                            stack[idx++] = Move(this, s, ahead, legalFlag | ROOK);
-                            stack[idx++] = Move(this, s, ahead, legalFlag | QUEEN);
-                        }
-                        else {
-                            stack[idx++] = Move(this, s, ahead, legalFlag);
-                        }
-                    }
-
-                    bool doubleJumpAllowed = color == WHITE ? (s >> 3 == 1) : (s >> 3 == 6);
-                    int8 doubleAhead = ahead + 8 - 16 * c;
-                    if (doubleJumpAllowed && !peices[doubleAhead] && (!checks || checkingSquares.count(doubleAhead))) {
-                        stack[idx++] = Move(this, s, doubleAhead, legalFlag);
-                    }
-                }
-
-                // Pawn captures
-                if (file != 0 && peices[ahead - 1] && peices[ahead - 1] >> 3 == e && (!checks || checkingSquares.count(ahead - 1))) {
-                    if (promotion) {
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag | KNIGHT);
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag | BISHOP);
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag | ROOK);
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag | QUEEN);
-                    }
-                    else {
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag);
-                    }
-                }
-                if (file != 7 && peices[ahead + 1] && peices[ahead + 1] >> 3 == e && (!checks || checkingSquares.count(ahead + 1))) {
-                    if (promotion) {
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag | KNIGHT);
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag | BISHOP);
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag | ROOK);
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag | QUEEN);
-                    }
-                    else {
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag);
-                    }
-                }
-                break;
-            }
-            case KNIGHT: {
-                uint8 t;
-                for (uint8 j = 1; j < KNIGHT_MOVES[s][0]; ++j) {
-                    t = KNIGHT_MOVES[s][j];
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                }
-                break;
-            }
-            case BISHOP:
-            case ROOK:
-            case QUEEN: {
-                if ((peices[s] & 0b111) == BISHOP) {
-                    goto bishopMoves;
-                }
-
-                for (int8 t = s - 8; t >= DIRECTION_BOUNDS[s][B]; t -= 8) {
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    if (peices[t]) {
-                        break;
-                    }
-                }
-
-                for (int8 t = s + 8; t <= DIRECTION_BOUNDS[s][F]; t += 8) {
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    if (peices[t]) {
-                        break;
-                    }
-                }
-
-                for (int8 t = s - 1; t >= DIRECTION_BOUNDS[s][L]; t -= 1) {
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    if (peices[t]) {
-                        break;
-                    }
-                }
+    if (captured) {
+        uint8 captureSquare = move.isEnPassant() ? move.target() - 8 + 16 * (color >> 3) : move.target();
+        earlygameChange -= EARLYGAME_PEICE_VALUE[captured][captureSquare];
+        endgameChange -= ENDGAME_PEICE_VALUE[captured][captureSquare];
+    }
 
-                for (int8 t = s + 1; t <= DIRECTION_BOUNDS[s][R]; t += 1) {
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    if (peices[t]) {
-                        break;
-                    }
-                }
+    // Rook also moves when castling
+    if (move.isCastling()) {
+        uint8 castlingRank = move.target() & 0b11111000;
+        uint8 rookStart = move.target() % 8 < 4 ? castlingRank : castlingRank + 7;
+        uint8 rookEnd = move.target() % 8 < 4 ? castlingRank + 3 : castlingRank + 5;
 
-                if ((peices[s] & 0b111) == ROOK) {
-                    break;
-                }
-            bishopMoves:
+        earlygameChange += EARLYGAME_PEICE_VALUE[color + ROOK][rookEnd] - EARLYGAME_PEICE_VALUE[color + ROOK][rookStart];
+        endgameChange += ENDGAME_PEICE_VALUE[color + ROOK][rookEnd] - ENDGAME_PEICE_VALUE[color + ROOK][rookStart];
+    }
+}
 
-                for (int8 t = s - 9; t >= DIRECTION_BOUNDS[s][BL]; t -= 9) {
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    if (peices[t]) {
-                        break;
-                    }
-                }
+uint64 EngineV1_3::attackersTo(uint8 square, uint64 occupied) const noexcept
+{
+    uint64 bishops = pos.peiceBitboards[WHITE + BISHOP] | pos.peiceBitboards[BLACK + BISHOP] | pos.peiceBitboards[WHITE + QUEEN] | pos.peiceBitboards[BLACK + QUEEN];
+    uint64 rooks = pos.peiceBitboards[WHITE + ROOK] | pos.peiceBitboards[BLACK + ROOK] | pos.peiceBitboards[WHITE + QUEEN] | pos.peiceBitboards[BLACK + QUEEN];
 
-                for (int8 t = s + 9; t <= DIRECTION_BOUNDS[s][FR]; t += 9) {
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    if (peices[t]) {
-                        break;
-                    }
-                }
+    return (bitboards::PAWN_ATTACKS[0][square] & pos.peiceBitboards[BLACK + PAWN])
+        | (bitboards::PAWN_ATTACKS[1][square] & pos.peiceBitboards[WHITE + PAWN])
+        | (bitboards::KNIGHT_ATTACKS[square] & (pos.peiceBitboards[WHITE + KNIGHT] | pos.peiceBitboards[BLACK + KNIGHT]))
+        | (bitboards::KING_ATTACKS[square] & (pos.peiceBitboards[WHITE + KING] | pos.peiceBitboards[BLACK + KING]))
+        | (bitboards::bishopAttacks(square, occupied) & bishops)
+        | (bitboards::rookAttacks(square, occupied) & rooks);
+}
 
-                for (int8 t = s - 7; t >= DIRECTION_BOUNDS[s][BR]; t -= 7) {
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    if (peices[t]) {
-                        break;
-                    }
-                }
+uint64 EngineV1_3::pinnedPeices(uint8 c) const noexcept
+{
+    uint8 enemy = !c << 3;
+    uint8 king = pos.kingIndex[c];
+    uint64 occupied = pos.colorBitboards[0] | pos.colorBitboards[1];
 
-                for (int8 t = s + 7; t <= DIRECTION_BOUNDS[s][FL]; t += 7) {
-                    if ((!peices[t] || peices[t] >> 3 == e) && (!checks || checkingSquares.count(t))) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    if (peices[t]) {
-                        break;
-                    }
-                }
+    // Enemy sliders lined up with the king on an empty board
+    uint64 snipers = (bitboards::rookAttacks(king, 0) & (pos.peiceBitboards[enemy + ROOK] | pos.peiceBitboards[enemy + QUEEN]))
+        | (bitboards::bishopAttacks(king, 0) & (pos.peiceBitboards[enemy + BISHOP] | pos.peiceBitboards[enemy + QUEEN]));
 
-                break;
-            }
-            case KING: {
-                uint8 t;
-                for (uint8 j = 1; j < KING_MOVES[s][0]; ++j) {
-                    t = KING_MOVES[s][j];
-                    if (!peices[t] || peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, Move::NONE);
-                    }
-                }
-            }
-            }
+    // A peice is pinned if it is the only peice between the king and a sniper
+    uint64 pinned = 0;
+    while (snipers) {
+        uint64 blockers = bitboards::BETWEEN[king][bitboards::popLsb(snipers)] & occupied;
+        if (blockers && !(blockers & (blockers - 1))) {
+            pinned |= blockers & pos.colorBitboards[c];
         }
     }
-    return checks;
+    return pinned;
 }
 
-std::vector<EngineV1_3::Move> EngineV1_3::legalMoves()
+bool EngineV1_3::decodeLegalMove(uint16 encodedMove, Move* stack, uint32 idx, Move& move) noexcept
 {
-    Move moves[225];
-    uint32 end = 0;
-    generatePseudoLegalMoves(moves, end);
+    uint8 start = encodedMove & 0b111111;
+
+    if (!(pos.colorBitboards[pos.totalHalfmoves % 2] & bitboards::bit(start))) {
+        return false;
+    }
 
-    std::vector<Move> legalMoves;
+    // Generate only the moves of the peice on the start square
+    uint32 end = idx;
+    generateLegalMoves(stack, end, ALL_MOVES, bitboards::bit(start));
 
-    for (uint32 i = 0; i < end; ++i) {
-        if (isLegal(moves[i])) {
-            legalMoves.push_back(moves[i]);
+    for (uint32 i = idx; i < end; ++i) {
+        if (stack[i].encoded() == encodedMove) {
+            move = stack[i];
+            return true;
         }
     }
-
-    return legalMoves;
+    return false;
 }
 
-void EngineV1_3::generateCaptures(Move* stack, uint32& idx, bool* pinnedPeices) const
+int32 EngineV1_3::staticExchangeEvaluation(Move move) const noexcept
 {
-    uint8 c = totalHalfmoves % 2;
-    uint8 color = c << 3;
-    uint8 e = !color;
-    uint8 enemy = e << 3;
+    static constexpr int32 SEE_PEICE_VALUES[7] = { 0, 100, 320, 330, 500, 900, 20000 };
 
-    for (uint8 s = 0; s < 64; ++s) {
-        if (peices[s] && peices[s] >> 3 == c) {
-            uint8 legalFlag = pinnedPeices[s] ? Move::NONE : Move::LEGAL;
-
-            switch (peices[s] & 0b111) {
-            case PAWN: {
-                uint8 file = s % 8;
-                uint8 ahead = s + 8 - 16 * c;
-                bool promotion = color == WHITE ? (s >> 3 == 6) : (s >> 3 == 1);
-
-                // Pawn captures
-                if (file != 0 && peices[ahead - 1] && peices[ahead - 1] >> 3 == e) {
-                    if (promotion) {
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag | KNIGHT);
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag | BISHOP);
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag | ROOK);
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag | QUEEN);
-                    }
-                    else {
-                        stack[idx++] = Move(this, s, ahead - 1, legalFlag);
-                    }
-                }
-                if (file != 7 && peices[ahead + 1] && peices[ahead + 1] >> 3 == e) {
-                    if (promotion) {
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag | KNIGHT);
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag | BISHOP);
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag | ROOK);
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag | QUEEN);
-                    }
-                    else {
-                        stack[idx++] = Move(this, s, ahead + 1, legalFlag);
-                    }
-                }
-                break;
-            }
-            case KNIGHT: {
-                uint8 t;
-                for (uint8 j = 1; j < KNIGHT_MOVES[s][0]; ++j) {
-                    t = KNIGHT_MOVES[s][j];
-                    if (peices[t] && peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                }
-                break;
-            }
-            case BISHOP:
-            case ROOK:
-            case QUEEN: {
-                if ((peices[s] & 0b111) == BISHOP) {
-                    goto bishopMoves;
-                }
+    uint8 target = move.target();
+    uint8 c = movingPeice(move) >> 3;
 
-                for (int8 t = s - 8; t >= DIRECTION_BOUNDS[s][B]; t -= 8) {
-                    if (!peices[t]) {
-                        continue;
-                    }
-                    if (peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    break;
-                }
+    uint64 occupied = (pos.colorBitboards[0] | pos.colorBitboards[1]) ^ bitboards::bit(move.start());
+    if (move.isEnPassant()) {
+        occupied ^= bitboards::bit(target - 8 + 16 * c);
+    }
 
-                for (int8 t = s + 8; t <= DIRECTION_BOUNDS[s][F]; t += 8) {
-                    if (!peices[t]) {
-                        continue;
-                    }
-                    if (peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    break;
-                }
+    uint64 diagonalSliders = pos.peiceBitboards[WHITE + BISHOP] | pos.peiceBitboards[BLACK + BISHOP] | pos.peiceBitboards[WHITE + QUEEN] | pos.peiceBitboards[BLACK + QUEEN];
+    uint64 orthogonalSliders = pos.peiceBitboards[WHITE + ROOK] | pos.peiceBitboards[BLACK + ROOK] | pos.peiceBitboards[WHITE + QUEEN] | pos.peiceBitboards[BLACK + QUEEN];
+    uint64 attackers = attackersTo(target, occupied) & occupied;
 
-                for (int8 t = s - 1; t >= DIRECTION_BOUNDS[s][L]; t -= 1) {
-                    if (!peices[t]) {
-                        continue;
-                    }
-                    if (peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    break;
-                }
+    // gain[i] is the material won by the side making capture i if the exchange stops after it
+    int32 gain[32];
+    uint8 depth = 0;
+    gain[0] = SEE_PEICE_VALUES[capturedPeice(move) & 0b111];
+    int32 onTarget = SEE_PEICE_VALUES[movingPeice(move) & 0b111];
+    if (move.promotion()) {
+        gain[0] += SEE_PEICE_VALUES[move.promotion()] - SEE_PEICE_VALUES[PAWN];
+        onTarget = SEE_PEICE_VALUES[move.promotion()];
+    }
 
-                for (int8 t = s + 1; t <= DIRECTION_BOUNDS[s][R]; t += 1) {
-                    if (!peices[t]) {
-                        continue;
-                    }
-                    if (peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    break;
-                }
+    uint8 side = !c;
+    while (true) {
+        uint64 sideAttackers = attackers & pos.colorBitboards[side];
+        if (!sideAttackers) {
+            break;
+        }
 
-                if ((peices[s] & 0b111) == ROOK) {
-                    break;
-                }
-            bishopMoves:
+        // Least valuable attacker recaptures
+        uint8 peice = PAWN;
+        uint64 attacker = sideAttackers & pos.peiceBitboards[(side << 3) + PAWN];
+        while (!attacker) {
+            ++peice;
+            attacker = sideAttackers & pos.peiceBitboards[(side << 3) + peice];
+        }
 
-                for (int8 t = s - 9; t >= DIRECTION_BOUNDS[s][BL]; t -= 9) {
-                    if (!peices[t]) {
-                        continue;
-                    }
-                    if (peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    break;
-                }
+        ++depth;
+        gain[depth] = onTarget - gain[depth - 1];
+        // Neither side can gain by continuing
+        if (std::max(-gain[depth - 1], gain[depth]) < 0 || depth == 31) {
+            break;
+        }
 
-                for (int8 t = s + 9; t <= DIRECTION_BOUNDS[s][FR]; t += 9) {
-                    if (!peices[t]) {
-                        continue;
-                    }
-                    if (peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    break;
-                }
+        // Remove the attacker and add any sliders behind it
+        occupied ^= attacker & (0 - attacker);
+        attackers |= (bitboards::bishopAttacks(target, occupied) & diagonalSliders) | (bitboards::rookAttacks(target, occupied) & orthogonalSliders);
+        attackers &= occupied;
 
-                for (int8 t = s - 7; t >= DIRECTION_BOUNDS[s][BR]; t -= 7) {
-                    if (!peices[t]) {
-                        continue;
-                    }
-                    if (peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    break;
-                }
+        onTarget = SEE_PEICE_VALUES[peice];
+        side = !side;
+    }
 
-                for (int8 t = s + 7; t <= DIRECTION_BOUNDS[s][FL]; t += 7) {
-                    if (!peices[t]) {
-                        continue;
-                    }
-                    if (peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, legalFlag);
-                    }
-                    break;
-                }
-                break;
-            }
-            case KING: {
-                uint8 t;
-                for (uint8 j = 1; j < KING_MOVES[s][0]; ++j) {
-                    t = KING_MOVES[s][j];
-                    if (peices[t] && peices[t] >> 3 == e) {
-                        stack[idx++] = Move(this, s, t, Move::NONE);
-                    }
-                }
-            }
-            }
-        }
+    // Each side can choose to stop capturing
+    for (; depth > 0; --depth) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
     }
+    return gain[0];
 }
 
-bool EngineV1_3::makeMove(EngineV1_3::Move& move, uint8 plyFromRoot)
+template <std::uint_fast8_t color>
+void EngineV1_3::toggleBitboards(Move move, uint8 moving, uint8 captured) noexcept
 {
-    uint8 c = move.moving() >> 3;
-    uint8 color = c << 3;
-    uint8 e = !color;
-    uint8 enemy = e << 3;
+    constexpr uint8 c = color >> 3;
+    uint64 startBit = bitboards::bit(move.start());
+    uint64 targetBit = bitboards::bit(move.target());
 
-    // CHECK LEGALITY
-    // Seperately check legality of castling moves
-    if (move.isCastling() && !move.legalFlagSet()) {
-        if (!castlingMoveIsLegal(move)) {
-            return false;
-        }
-    }
+    pos.peiceBitboards[moving] ^= startBit;
+    pos.peiceBitboards[move.promotion() ? color + move.promotion() : moving] ^= targetBit;
+    pos.colorBitboards[c] ^= startBit | targetBit;
 
-    // Update peices array first to check legality
-    peices[move.start()] = 0;
-    peices[move.target()] = move.promotion() ? color + move.promotion() : move.moving();
-    if (move.isEnPassant()) {
-        peices[move.target() - 8 + 16 * c] = 0;
+    if (captured) {
+        uint64 captureBit = bitboards::bit(move.isEnPassant() ? move.target() - 8 + 16 * c : move.target());
+        pos.peiceBitboards[captured] ^= captureBit;
+        pos.colorBitboards[!c] ^= captureBit;
     }
+}
 
-    // Update king index
-    if ((move.moving() & 0b111) == KING) {
-        kingIndex[c] = move.target();
+void EngineV1_3::makeMove(EngineV1_3::Move move, uint8 plyFromRoot)
+{
+    if (pos.totalHalfmoves % 2) {
+        makeMove<BLACK>(move, plyFromRoot);
     }
+    else {
+        makeMove<WHITE>(move, plyFromRoot);
+    }
+}
+
+template <std::uint_fast8_t color, bool prefetchEntry>
+void EngineV1_3::makeMove(EngineV1_3::Move move, uint8 plyFromRoot)
+{
+    constexpr uint8 c = color >> 3;
+    constexpr uint8 e = !c;
+
+    uint8 moving = movingPeice(move);
+    uint8 captured = capturedPeice(move);
+    uint8 captureSquare = move.isEnPassant() ? move.target() - 8 + 16 * c : move.target();
 
-    // Check if move was illegal
-    if (!move.legalFlagSet() && inCheck(c)) {
-        // Undo change
-        peices[move.start()] = move.moving();
-        peices[move.target()] = move.captured();
-        if (move.isEnPassant()) {
-            peices[move.target()] = 0;
-            peices[move.target() - 8 + 16 * c] = move.captured();
+    // Castling moves the rook from the corner to the other side of the king
+    uint8 rookStart = 0;
+    uint8 rookEnd = 0;
+    if (move.isCastling()) {
+        uint8 castlingRank = move.target() & 0b11111000;
+        if (move.target() % 8 < 4) {
+            // Queenside castling
+            rookStart = castlingRank;
+            rookEnd = castlingRank + 3;
         }
-        // Undo king index
-        if ((move.moving() & 0b111) == KING) {
-            kingIndex[c] = move.start();
+        else {
+            // Kingside castling
+            rookStart = castlingRank + 7;
+            rookEnd = castlingRank + 5;
         }
-        return false;
     }
 
-    move.setLegalFlag();
-
-    // UPDATE PEICE DATA / ZOBRIST HASH
-    // Update zobrist hash for turn change
-    zobrist ^= ZOBRIST_TURN_KEY;
+    // ZOBRIST HASH
+    // The hash of the new position is computed first, so its transposition table cluster is loaded while the rest of the move is made
+    // Moving the king or a rook, or capturing a rook loses castling rights
+    uint8 castlingRights = pos.state->castlingRights & CASTLING_RIGHTS_KEPT[move.start()] & CASTLING_RIGHTS_KEPT[move.target()];
+    uint64 zobrist = pos.state->zobrist ^ ZOBRIST_TURN_KEY;
+    zobrist ^= ZOBRIST_PEICE_KEYS[c][(moving & 0b111) - 1][move.start()];
+    zobrist ^= ZOBRIST_PEICE_KEYS[c][(move.promotion() ? move.promotion() : moving & 0b111) - 1][move.target()];
+    if (captured) {
+        zobrist ^= ZOBRIST_PEICE_KEYS[e][(captured & 0b111) - 1][captureSquare];
+    }
+    if (move.isCastling()) {
+        zobrist ^= ZOBRIST_PEICE_KEYS[c][ROOK - 1][rookStart] ^ ZOBRIST_PEICE_KEYS[c][ROOK - 1][rookEnd];
+    }
+    if (castlingRights != pos.state->castlingRights) {
+        zobrist ^= castlingRightsZobrist(castlingRights ^ pos.state->castlingRights);
+    }
+    if constexpr (prefetchEntry) {
+        ttable->prefetch(zobrist);
+    }
 
-    earlygamePositionalMaterialInbalance += move.earlygamePositionalMaterialChange();
-    endgamePositionalMaterialInbalance += move.endgamePositionalMaterialChange();
+    // Positional material change is read from the board before the move is played
+    int32 earlyPosmat;
+    int32 endPosmat;
+    positionalMaterialChange(move, earlyPosmat, endPosmat);
 
-    // Update zobrist hash, numpieces and positonal imbalance for moving peice
-    zobrist ^= ZOBRIST_PEICE_KEYS[c][(move.moving() & 0b111) - 1][move.start()];
+    // Update peices array and bitboards
+    pos.peices[move.start()] = 0;
+    pos.peices[move.target()] = move.promotion() ? color + move.promotion() : moving;
+    if (move.isEnPassant()) {
+        pos.peices[move.target() - 8 + 16 * c] = 0;
+    }
+    toggleBitboards<color>(move, moving, captured);
 
-    uint16 rem1 = (2 * ((move.moving() & 0b111) - 1) + c) * 64 + move.start();
+    // Update king index
+    if ((moving & 0b111) == KING) {
+        pos.kingIndex[c] = move.target();
+    }
+
+    // PUSH NEW STATE
+    // The previous state is left untouched so that unmakeMove only has to pop the stack
+    StateInfo* previous = pos.state++;
+    pos.state->zobrist = zobrist;
+    pos.state->earlygamePositionalMaterialInbalance = previous->earlygamePositionalMaterialInbalance + earlyPosmat;
+    pos.state->endgamePositionalMaterialInbalance = previous->endgamePositionalMaterialInbalance + endPosmat;
+    pos.state->castlingRights = castlingRights;
+    pos.state->enPassantSquare = 0;
+    pos.state->halfmovesSincePawnMoveOrCapture = captured || (moving & 0b111) == PAWN ? 0 : previous->halfmovesSincePawnMoveOrCapture + 1;
+    pos.state->capturedPeice = captured;
+
+    // UPDATE PEICE DATA
+    // Update numpieces and NNUE features for moving peice
+    uint16 rem1 = (2 * ((moving & 0b111) - 1) + c) * 64 + move.start();
     uint16 add1;
 
     if (move.promotion()) {
-        zobrist ^= ZOBRIST_PEICE_KEYS[c][move.promotion() - 1][move.target()];
-        --numPeices[move.moving()];
-        ++numPeices[color + move.promotion()];
-        material_stage_weight -= PEICE_STAGE_WEIGHTS[move.moving()];
-        material_stage_weight += PEICE_STAGE_WEIGHTS[color + move.promotion()];
+        --pos.numPeices[moving];
+        ++pos.numPeices[color + move.promotion()];
+        pos.material_stage_weight -= PEICE_STAGE_WEIGHTS[moving];
+        pos.material_stage_weight += PEICE_STAGE_WEIGHTS[color + move.promotion()];
 
         add1 = (2 * (move.promotion() - 1) + c) * 64 + move.target();
     }
     else {
-        zobrist ^= ZOBRIST_PEICE_KEYS[c][(move.moving() & 0b111) - 1][move.target()];
-        add1 = (2 * ((move.moving() & 0b111) - 1) + c) * 64 + move.target();
+        add1 = (2 * ((moving & 0b111) - 1) + c) * 64 + move.target();
     }
 
 
-    // Update zobrist hash and peice indices set for capture
-    if (move.captured()) {
-        uint8 captureSquare = move.isEnPassant() ? move.target() - 8 + 16 * c : move.target();
-        zobrist ^= ZOBRIST_PEICE_KEYS[e][(move.captured() & 0b111) - 1][captureSquare];
-        --numPeices[move.captured()];
-        --numTotalPeices[e];
-        material_stage_weight -= PEICE_STAGE_WEIGHTS[move.captured()];
+    // Update peice indices set for capture
+    if (captured) {
+        --pos.numPeices[captured];
+        --pos.numTotalPeices[e];
+        pos.material_stage_weight -= PEICE_STAGE_WEIGHTS[captured];
 
-        uint16 rem2 = (2 * ((move.captured() & 0b111) - 1) + e) * 64 + captureSquare;
+        uint16 rem2 = (2 * ((captured & 0b111) - 1) + e) * 64 + captureSquare;
         nnue.updateAccumulatorCapture(accumulatorBuffer[plyFromRoot], accumulatorBuffer[plyFromRoot + 1], rem1, rem2, add1);
     }
     else {
@@ -1767,25 +1459,10 @@ bool EngineV1_3::makeMove(EngineV1_3::Move& move, uint8 plyFromRoot)
 
     // Update rooks for castling
     if (move.isCastling()) {
-        uint8 rookStart;
-        uint8 rookEnd;
-
-        uint8 castlingRank = move.target() & 0b11111000;
-        if (move.target() % 8 < 4) {
-            // Queenside castling
-            rookStart = castlingRank;
-            rookEnd = castlingRank + 3;
-        }
-        else {
-            // Kingside castling
-            rookStart = castlingRank + 7;
-            rookEnd = castlingRank + 5;
-        }
-
-        peices[rookEnd] = peices[rookStart];
-        peices[rookStart] = 0;
-        zobrist ^= ZOBRIST_PEICE_KEYS[c][ROOK - 1][rookStart];
-        zobrist ^= ZOBRIST_PEICE_KEYS[c][ROOK - 1][rookEnd];
+        pos.peices[rookEnd] = pos.peices[rookStart];
+        pos.peices[rookStart] = 0;
+        pos.peiceBitboards[color + ROOK] ^= bitboards::bit(rookStart) | bitboards::bit(rookEnd);
+        pos.colorBitboards[c] ^= bitboards::bit(rookStart) | bitboards::bit(rookEnd);
 
         uint16 rem2 = (2 * (ROOK - 1) + c) * 64 + rookStart;
         uint16 add2 = (2 * (ROOK - 1) + c) * 64 + rookEnd;
@@ -1794,91 +1471,57 @@ bool EngineV1_3::makeMove(EngineV1_3::Move& move, uint8 plyFromRoot)
     }
 
     // UPDATE BOARD FLAGS
-    // increment counters / Update position history
-    ++totalHalfmoves;
+    ++pos.totalHalfmoves;
 
-    if (!move.captured() && move.moving() != color + PAWN) {
-        positionInfo[positionInfoIndex + 1] |= static_cast<uint32>(halfMovesSincePawnMoveOrCapture() + 1) << 20;
-    }
-    ++positionInfoIndex;
-
-    // En passant file
-    if ((move.moving() & 0b111) == PAWN && std::abs(move.target() - move.start()) == 16) {
-        positionInfo[positionInfoIndex] |= static_cast<uint32>((move.start() + move.target()) / 2) << 26;
+    // En passant square
+    if ((moving & 0b111) == PAWN && std::abs(move.target() - move.start()) == 16) {
+        pos.state->enPassantSquare = (move.start() + move.target()) / 2;
     }
+}
 
-    // update castling rights
-    if (!kingsideCastlingRightsLost[c]) {
-        if (move.moving() == color + KING || (move.moving() == color + ROOK && (color == WHITE ? move.start() == 7 : move.start() == 63))) {
-            kingsideCastlingRightsLost[c] = totalHalfmoves;
-            zobrist ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[c];
-        }
-    }
-    if (!queensideCastlingRightsLost[c]) {
-        if (move.moving() == color + KING || (move.moving() == color + ROOK && (color == WHITE ? move.start() == 0 : move.start() == 56))) {
-            queensideCastlingRightsLost[c] = totalHalfmoves;
-            zobrist ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[c];
-        }
-    }
-    if (!kingsideCastlingRightsLost[e]) {
-        if (color == BLACK ? move.target() == 7 : move.target() == 63) {
-            kingsideCastlingRightsLost[e] = totalHalfmoves;
-            zobrist ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[e];
-        }
+void EngineV1_3::unmakeMove(EngineV1_3::Move move)
+{
+    // The side that played the move is not the side to move
+    if (pos.totalHalfmoves % 2) {
+        unmakeMove<WHITE>(move);
     }
-    if (!queensideCastlingRightsLost[e]) {
-        if (color == BLACK ? move.target() == 0 : move.target() == 56) {
-            queensideCastlingRightsLost[e] = totalHalfmoves;
-            zobrist ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[e];
-        }
+    else {
+        unmakeMove<BLACK>(move);
     }
-
-    positionInfo[positionInfoIndex] |= zobrist >> 44;
-
-    return true;
 }
 
-void EngineV1_3::unmakeMove(EngineV1_3::Move& move)
+template <std::uint_fast8_t color>
+void EngineV1_3::unmakeMove(EngineV1_3::Move move)
 {
-    uint8 c = move.moving() >> 3;
-    uint8 color = c << 3;
-    uint8 e = !color;
-    uint8 enemy = e << 3;
+    constexpr uint8 c = color >> 3;
+    constexpr uint8 e = !c;
 
-    // UNDO PEICE DATA / ZOBRIST HASH
-    // Undo zobrist hash for turn change
-    zobrist ^= ZOBRIST_TURN_KEY;
+    uint8 captured = pos.state->capturedPeice;
+    uint8 moving = move.promotion() ? color + PAWN : pos.peices[move.target()];
 
-    earlygamePositionalMaterialInbalance -= move.earlygamePositionalMaterialChange();
-    endgamePositionalMaterialInbalance -= move.endgamePositionalMaterialChange();
+    // Pop the state (zobrist hash, castling rights, en passant square and positional inbalance are restored with it)
+    --pos.state;
 
-    // Undo peice array, zobrist hash, and peice indices set for moving peice
-    peices[move.start()] = move.moving();
-    peices[move.target()] = move.captured();
+    // UNDO PEICE DATA
+    pos.peices[move.start()] = moving;
+    pos.peices[move.target()] = captured;
     if (move.isEnPassant()) {
-        peices[move.target()] = 0;
-        peices[move.target() - 8 + 16 * c] = move.captured();
+        pos.peices[move.target()] = 0;
+        pos.peices[move.target() - 8 + 16 * c] = captured;
     }
-    if (move.promotion()) {
-        ++numPeices[move.moving()];
-        --numPeices[color + move.promotion()];
-        material_stage_weight += PEICE_STAGE_WEIGHTS[move.moving()];
-        material_stage_weight -= PEICE_STAGE_WEIGHTS[color + move.promotion()];
-        zobrist ^= ZOBRIST_PEICE_KEYS[c][move.promotion() - 1][move.target()];
+    toggleBitboards<color>(move, moving, captured);
 
+    if (move.promotion()) {
+        ++pos.numPeices[moving];
+        --pos.numPeices[color + move.promotion()];
+        pos.material_stage_weight += PEICE_STAGE_WEIGHTS[moving];
+        pos.material_stage_weight -= PEICE_STAGE_WEIGHTS[color + move.promotion()];
     }
-    else {
-        zobrist ^= ZOBRIST_PEICE_KEYS[c][(move.moving() & 0b111) - 1][move.target()];
-    }
-    zobrist ^= ZOBRIST_PEICE_KEYS[c][(move.moving() & 0b111) - 1][move.start()];
 
-    // Undo zobrist hash and peice indices set for capture
-    if (move.captured()) {
-        uint8 captureSquare = move.isEnPassant() ? move.target() - 8 + 16 * c : move.target();
-        zobrist ^= ZOBRIST_PEICE_KEYS[e][(move.captured() & 0b111) - 1][captureSquare];
-        material_stage_weight += PEICE_STAGE_WEIGHTS[move.captured()];
-        ++numPeices[move.captured()];
-        ++numTotalPeices[e];
+    if (captured) {
+        pos.material_stage_weight += PEICE_STAGE_WEIGHTS[captured];
+        ++pos.numPeices[captured];
+        ++pos.numTotalPeices[e];
     }
 
     // Undo rooks for castling
@@ -1898,40 +1541,38 @@ void EngineV1_3::unmakeMove(EngineV1_3::Move& move)
             rookEnd = castlingRank + 5;
         }
 
-        peices[rookStart] = peices[rookEnd];
-        peices[rookEnd] = 0;
-        zobrist ^= ZOBRIST_PEICE_KEYS[c][ROOK - 1][rookStart];
-        zobrist ^= ZOBRIST_PEICE_KEYS[c][ROOK - 1][rookEnd];
+        pos.peices[rookStart] = pos.peices[rookEnd];
+        pos.peices[rookEnd] = 0;
+        pos.peiceBitboards[color + ROOK] ^= bitboards::bit(rookStart) | bitboards::bit(rookEnd);
+        pos.colorBitboards[c] ^= bitboards::bit(rookStart) | bitboards::bit(rookEnd);
     }
 
-    // UBDO BOARD FLAGS
     // Undo king index
-    if ((move.moving() & 0b111) == KING) {
-        kingIndex[c] = move.start();
+    if ((moving & 0b111) == KING) {
+        pos.kingIndex[c] = move.start();
     }
 
-    // undo castling rights
-    if (kingsideCastlingRightsLost[c] == totalHalfmoves) {
-        kingsideCastlingRightsLost[c] = 0;
-        zobrist ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[c];
-    }
-    if (queensideCastlingRightsLost[c] == totalHalfmoves) {
-        queensideCastlingRightsLost[c] = 0;
-        zobrist ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[c];
+    --pos.totalHalfmoves;
+}
 
+template <std::uint_fast8_t color, bool prefetchEntry>
+inline void EngineV1_3::searchMakeMove(Move move, uint8 plyFromRoot, Position& parent)
+{
+    if constexpr (V1_3_COPY_MAKE) {
+        parent = pos;
     }
-    if (kingsideCastlingRightsLost[e] == totalHalfmoves) {
-        kingsideCastlingRightsLost[e] = 0;
-        zobrist ^= ZOBRIST_KINGSIDE_CASTLING_KEYS[e];
+    makeMove<color, prefetchEntry>(move, plyFromRoot);
+}
+
+template <std::uint_fast8_t color>
+inline void EngineV1_3::searchUnmakeMove(Move move, const Position& parent)
+{
+    if constexpr (V1_3_COPY_MAKE) {
+        pos = parent;
     }
-    if (queensideCastlingRightsLost[e] == totalHalfmoves) {
-        queensideCastlingRightsLost[e] = 0;
-        zobrist ^= ZOBRIST_QUEENSIDE_CASTLING_KEYS[e];
+    else {
+        unmakeMove<color>(move);
     }
-
-    // decrement counters
-    --totalHalfmoves;
-    positionInfo[positionInfoIndex--] = 0;
 }
 
 inline bool EngineV1_3::isDraw() const
@@ -1941,29 +1582,22 @@ inline bool EngineV1_3::isDraw() const
 
 inline uint8 EngineV1_3::halfMovesSincePawnMoveOrCapture() const noexcept
 {
-    return static_cast<uint8>((positionInfo[positionInfoIndex] >> 20) & 0b111111);
+    return pos.state->halfmovesSincePawnMoveOrCapture;
 }
 
 inline uint8 EngineV1_3::eligibleEnpassantSquare() const noexcept
 {
-    return static_cast<uint8>(positionInfo[positionInfoIndex] >> 26);
+    return pos.state->enPassantSquare;
 }
 
 bool EngineV1_3::isDrawByThreefoldRepitition() const noexcept
 {
-    if (halfMovesSincePawnMoveOrCapture() < 8) {
-        return false;
-    }
-
-    uint8 index = positionInfoIndex - 2;
-    uint8 numPossibleRepitions = halfMovesSincePawnMoveOrCapture() / 2 - 1;
-
-    uint32 currentHash = static_cast<uint32>(zobrist >> 44);
+    // Only positions since the last pawn move or capture that are still on the state stack can repeat
+    std::ptrdiff_t plies = std::min<std::ptrdiff_t>(halfMovesSincePawnMoveOrCapture(), pos.state - stateStack.data());
     bool repititionFound = false;
 
-    for (uint8 i = 0; i < numPossibleRepitions; ++i) {
-        index -= 2;
-        if ((positionInfo[index] & ((1 << 20) - 1)) == currentHash) {
+    for (std::ptrdiff_t i = 4; i <= plies; i += 2) {
+        if ((pos.state - i)->zobrist == pos.state->zobrist) {
             if (repititionFound) {
                 return true;
             }
@@ -1975,34 +1609,26 @@ bool EngineV1_3::isDrawByThreefoldRepitition() const noexcept
 
 inline bool EngineV1_3::isDrawByFiftyMoveRule() const noexcept
 {
-    return halfMovesSincePawnMoveOrCapture() >= 50;
+    return halfMovesSincePawnMoveOrCapture() >= 100;
 }
 
 bool EngineV1_3::isDrawByInsufficientMaterial() const noexcept
 {
-    if (numTotalPeices[0] > 3 || numTotalPeices[1] > 3) {
+    if (pos.numTotalPeices[0] > 3 || pos.numTotalPeices[1] > 3) {
         return false;
     }
-    if (numTotalPeices[0] == 3 || numTotalPeices[1] == 3) {
-        return (numPeices[WHITE + KNIGHT] == 2 || numPeices[BLACK + KNIGHT] == 2) && (numTotalPeices[0] == 1 || numTotalPeices[1] == 1);
+    if (pos.numTotalPeices[0] == 3 || pos.numTotalPeices[1] == 3) {
+        return (pos.numPeices[WHITE + KNIGHT] == 2 || pos.numPeices[BLACK + KNIGHT] == 2) && (pos.numTotalPeices[0] == 1 || pos.numTotalPeices[1] == 1);
     }
-    return !(numPeices[WHITE + PAWN] || numPeices[BLACK + PAWN] || numPeices[WHITE + ROOK] || numPeices[BLACK + ROOK] || numPeices[WHITE + QUEEN] || numPeices[BLACK + QUEEN]);
+    return !(pos.numPeices[WHITE + PAWN] || pos.numPeices[BLACK + PAWN] || pos.numPeices[WHITE + ROOK] || pos.numPeices[BLACK + ROOK] || pos.numPeices[WHITE + QUEEN] || pos.numPeices[BLACK + QUEEN]);
 }
 
-bool EngineV1_3::repititionOcurred() const noexcept
-{
-    if (halfMovesSincePawnMoveOrCapture() < 4) {
-        return false;
-    }
-
-    uint8 index = positionInfoIndex - 2;
-    uint8 numPossibleRepitions = halfMovesSincePawnMoveOrCapture() / 2 - 1;
-
-    uint32 currentHash = static_cast<uint32>(zobrist >> 44);
+bool EngineV1_3::repititionOcurred() const noexcept
+{
+    std::ptrdiff_t plies = std::min<std::ptrdiff_t>(halfMovesSincePawnMoveOrCapture(), pos.state - stateStack.data());
 
-    for (uint8 i = 0; i < numPossibleRepitions; ++i) {
-        index -= 2;
-        if ((positionInfo[index] & ((1 << 20) - 1)) == currentHash) {
+    for (std::ptrdiff_t i = 4; i <= plies; i += 2) {
+        if ((pos.state - i)->zobrist == pos.state->zobrist) {
             return true;
         }
     }
@@ -2011,274 +1637,268 @@ bool EngineV1_3::repititionOcurred() const noexcept
 
 bool EngineV1_3::inCheck(uint8 c) const
 {
-    // TODO Backwards check searching during endgame
-
-    uint8 color = c << 3;
-    uint8 e = !c;
-    uint8 enemy = e << 3;
-    uint8 king = kingIndex[c];
+    return attackersTo(pos.kingIndex[c], pos.colorBitboards[0] | pos.colorBitboards[1]) & pos.colorBitboards[!c];
+}
 
-    // Pawn checks
-    uint8 kingFile = king % 8;
-    uint8 ahead = king + 8 - 16 * c;
-    if (kingFile != 0 && peices[ahead - 1] == enemy + PAWN) {
-        return true;
+void EngineV1_3::resetSearchMembers()
+{
+    nodesSearchedThisMove = 0;
+    for (uint8 i = 0; i < MAX_DEPTH; ++i) {
+        killerMoves[i][0] = 0;
+        killerMoves[i][1] = 0;
     }
-    if (kingFile != 7 && peices[ahead + 1] == enemy + PAWN) {
-        return true;
+}
+
+//SEARCH/EVAL METHODS
+inline std::uint64_t EngineV1_3::perftKey() const noexcept
+{
+    uint8 enPassantSquare = pos.state->enPassantSquare;
+    return enPassantSquare ? pos.state->zobrist ^ ZOBRIST_EN_PASSANT_KEYS[enPassantSquare % 8] : pos.state->zobrist;
+}
+
+std::uint64_t EngineV1_3::perft_h(uint8 plyFromRoot, uint8 depth, Move* moveStack, uint32 startMoves)
+{
+    return pos.totalHalfmoves % 2 ? perft_h<BLACK>(plyFromRoot, depth, moveStack, startMoves) : perft_h<WHITE>(plyFromRoot, depth, moveStack, startMoves);
+}
+
+template <std::uint_fast8_t color>
+std::uint64_t EngineV1_3::perft_h(uint8 plyFromRoot, uint8 depth, Move* moveStack, uint32 startMoves)
+{
+    if (depth == 0) {
+        return 1ULL;
     }
 
-    // Knight checks
-    for (uint8 j = 1; j < KNIGHT_MOVES[king][0]; ++j) {
-        if (peices[KNIGHT_MOVES[king][j]] == enemy + KNIGHT) {
-            return true;
+    // Subtrees of transpositions are only counted once (probed before generating moves, so a hit skips move generation)
+    // Bulk counted leaves are cheaper to generate than to look up
+    bool useTable = perftTable && !(V1_3_PERFT_BULK_COUNT && depth == 1);
+    std::uint64_t nodes = 0;
+    uint64 key = 0;
+    if (useTable) {
+        key = perftKey();
+        if (perftTable->probe(key, depth, nodes)) {
+            return nodes;
         }
     }
 
-    // sliding peice checks
-    for (int8 j = king - 8; j >= DIRECTION_BOUNDS[king][B]; j -= 8) {
-        if (peices[j]) {
-            if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                return true;
-            }
-            break;
+    uint32 endMoves = startMoves;
+    generateLegalMoves<color>(moveStack, endMoves);
+
+    // Every generated move is legal, so the leaves can be counted without playing them
+    if constexpr (V1_3_PERFT_BULK_COUNT) {
+        if (depth == 1) {
+            return endMoves - startMoves;
         }
     }
 
-    for (int8 j = king + 8; j <= DIRECTION_BOUNDS[king][F]; j += 8) {
-        if (peices[j]) {
-            if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                return true;
-            }
-            break;
-        }
+    Position parent;
+
+    // Perft does not use the transposition table
+    for (uint32 i = startMoves; i < endMoves; ++i) {
+        searchMakeMove<color, false>(moveStack[i], plyFromRoot, parent);
+        nodes += perft_h<color ^ BLACK>(plyFromRoot + 1, depth - 1, moveStack, endMoves);
+        searchUnmakeMove<color>(moveStack[i], parent);
     }
 
-    for (int8 j = king - 1; j >= DIRECTION_BOUNDS[king][L]; j -= 1) {
-        if (peices[j]) {
-            if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                return true;
-            }
-            break;
-        }
+    if (useTable) {
+        perftTable->store(key, depth, nodes);
     }
+    return nodes;
+}
 
-    for (int8 j = king + 1; j <= DIRECTION_BOUNDS[king][R]; j += 1) {
-        if (peices[j]) {
-            if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                return true;
-            }
-            break;
-        }
+void EngineV1_3::perft_parallel(uint8 depth, uint8 splitDepth, std::vector<std::uint64_t>& rootNodes)
+{
+    // Split the tree into tasks
+    std::vector<PerftTask> tasks = generatePerftTasks(splitDepth);
+
+    // Deal the tasks out in turn, so every thread starts with subtrees of every root move
+    unsigned numThreads = static_cast<unsigned>(std::min<size_t>(perftThreads, tasks.size()));
+    std::vector<PerftTaskQueue> queues(numThreads);
+    for (uint32 i = 0; i < tasks.size(); ++i) {
+        queues[i % numThreads].tasks.push_back(i);
     }
 
-    for (int8 j = king - 9; j >= DIRECTION_BOUNDS[king][BL]; j -= 9) {
-        if (peices[j]) {
-            if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                return true;
-            }
-            break;
+    // Every thread counts nodes into its own array, which are added together once all of the threads are done
+    std::vector<std::vector<std::uint64_t>> threadNodes(numThreads, std::vector<std::uint64_t>(rootNodes.size(), 0));
+
+    auto worker = [&](unsigned thread) {
+        EngineV1_3 clone(*this);
+        MoveList<Move, MOVE_STACK_CAPACITY> threadMoveStack;
+        uint32 taskIndex;
+        while (takePerftTask(queues, thread, taskIndex)) {
+            const PerftTask& t = tasks[taskIndex];
+            threadNodes[thread][t.rootMove] += clone.perftTask(t, depth, threadMoveStack.data());
         }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < numThreads; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread : threads) {
+        thread.join();
     }
 
-    for (int8 j = king + 9; j <= DIRECTION_BOUNDS[king][FR]; j += 9) {
-        if (peices[j]) {
-            if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                return true;
-            }
-            break;
+    for (const std::vector<std::uint64_t>& nodes : threadNodes) {
+        for (size_t i = 0; i < rootNodes.size(); ++i) {
+            rootNodes[i] += nodes[i];
         }
     }
+}
 
-    for (int8 j = king - 7; j >= DIRECTION_BOUNDS[king][BR]; j -= 7) {
-        if (peices[j]) {
-            if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                return true;
-            }
-            break;
-        }
+std::vector<EngineV1_3::PerftSplit> EngineV1_3::perftSplit(int splitDepth)
+{
+    // The tasks are made on the same move stack and state stack as perft, so they are bound by MAX_DEPTH too
+    static_assert(MAX_PERFT_SPLIT_DEPTH <= MAX_DEPTH, "Perft split depth must fit in the move stack!");
+    if (splitDepth < 1 || splitDepth > MAX_PERFT_SPLIT_DEPTH) {
+        throw std::invalid_argument("Perft split depth must be between 1 and " + std::to_string(MAX_PERFT_SPLIT_DEPTH) + "!");
     }
 
-    for (int8 j = king + 7; j <= DIRECTION_BOUNDS[king][FL]; j += 7) {
-        if (peices[j]) {
-            if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                return true;
-            }
-            break;
+    std::vector<PerftSplit> splits;
+    for (const PerftTask& task : generatePerftTasks(static_cast<uint8>(splitDepth))) {
+        for (uint8 i = 0; i < task.length; ++i) {
+            makeMove(task.path[i], i);
         }
-    }
 
-    // King checks (seems wierd, but needed for detecting illegal moves)
-    for (uint8 j = 1; j < KING_MOVES[king][0]; ++j) {
-        if (peices[KING_MOVES[king][j]] == enemy + KING) {
-            return true;
+        const Move& rootMove = enginePositionMoves[task.rootMove];
+        splits.push_back({ StandardMove(rootMove.start(), rootMove.target(), rootMove.promotion()), asFEN() });
+
+        for (uint8 i = task.length; i > 0; --i) {
+            unmakeMove(task.path[i - 1]);
         }
     }
+    return splits;
+}
 
-    return false;
+std::vector<EngineV1_3::PerftTask> EngineV1_3::generatePerftTasks(uint8 splitDepth)
+{
+    MoveList<Move, MOVE_STACK_CAPACITY> moveStack;
+
+    std::vector<PerftTask> tasks;
+    PerftTask task;
+    for (uint32 i = 0; i < enginePositionMoves.size(); ++i) {
+        task.rootMove = i;
+        task.path[0] = enginePositionMoves[i];
+        task.length = 1;
+        makeMove(enginePositionMoves[i], 0);
+        generatePerftTasks(splitDepth, moveStack.data(), 0, task, tasks);
+        unmakeMove(enginePositionMoves[i]);
+    }
+    return tasks;
 }
 
-bool EngineV1_3::isLegal(Move& move)
+void EngineV1_3::generatePerftTasks(uint8 splitDepth, Move* moveStack, uint32 startMoves, PerftTask& task, std::vector<PerftTask>& tasks)
 {
-    if (move.legalFlagSet()) {
-        return true;
+    if (task.length == splitDepth) {
+        tasks.push_back(task);
+        return;
     }
 
-    if (move.isCastling()) {
-        // Check if king is in check
-        if (inCheck()) {
-            return false;
-        }
+    uint32 endMoves = startMoves;
+    generateLegalMoves(moveStack, endMoves);
+
+    for (uint32 i = startMoves; i < endMoves; ++i) {
+        task.path[task.length] = moveStack[i];
+        makeMove(moveStack[i], task.length++);
+        generatePerftTasks(splitDepth, moveStack, endMoves, task, tasks);
+        unmakeMove(moveStack[i]);
+        --task.length;
+    }
+}
 
-        return castlingMoveIsLegal(move);
+std::uint64_t EngineV1_3::perftTask(const PerftTask& task, uint8 depth, Move* moveStack)
+{
+    for (uint8 i = 0; i < task.length; ++i) {
+        makeMove(task.path[i], i);
     }
 
-    if (makeMove(move, 0)) {
-        unmakeMove(move);
-        move.setLegalFlag();
-        return true;
+    std::uint64_t nodes = perft_h(task.length, depth - task.length, moveStack, 0);
+
+    for (uint8 i = task.length; i > 0; --i) {
+        unmakeMove(task.path[i - 1]);
     }
-    return false;
+    return nodes;
 }
 
-bool EngineV1_3::castlingMoveIsLegal(Move& move) {
-    if (move.legalFlagSet()) {
-        return true;
+void EngineV1_3::startSearchHelpers(SearchHelpers& helpers)
+{
+    if (searchThreads <= 1) {
+        return;
     }
 
-    uint8 c = totalHalfmoves % 2;
-    uint8 color = c << 3;
-    uint8 e = !color;
-    uint8 enemy = e << 3;
-    uint8 castlingRank = move.start() & 0b11111000;
+    // Copies are made before any thread starts, as the main thread plays moves on the engine as soon as it starts searching
+    helpers.results.resize(searchThreads - 1);
+    for (unsigned i = 1; i < searchThreads; ++i) {
+        helpers.engines.emplace_back(new EngineV1_3(*this));
+        helpers.engines.back()->stopSearch = &helpers.stop;
+    }
 
-    // Check if anything is attacking squares on king's path
-    uint8 s;
-    uint8 end;
-    if (move.target() - castlingRank < 4) {
-        s = castlingRank + 2;
-        end = castlingRank + 3;
+    for (unsigned i = 1; i < searchThreads; ++i) {
+        helpers.threads.emplace_back(&EngineV1_3::helperSearch, helpers.engines[i - 1].get(), i, std::ref(helpers.results[i - 1]));
     }
-    else {
-        s = castlingRank + 5;
-        end = castlingRank + 6;
+}
+
+void EngineV1_3::stopSearchHelpers(SearchHelpers& helpers)
+{
+    helpers.stop = true;
+    for (std::thread& thread : helpers.threads) {
+        thread.join();
     }
-    for (; s <= end; ++s) {
-        // Pawn attacks
-        uint8 file = s % 8;
-        uint8 ahead = s + 8 - 16 * c;
-        if (file != 0 && peices[ahead - 1] == enemy + PAWN) {
-            return false;
-        }
-        if (file != 7 && peices[ahead + 1] == enemy + PAWN) {
-            return false;
-        }
+}
 
-        // Knight attacks
-        for (uint8 j = 1; j < KNIGHT_MOVES[s][0]; ++j) {
-            if (peices[KNIGHT_MOVES[s][j]] == enemy + KNIGHT) {
-                return false;
-            }
-        }
+void EngineV1_3::helperSearch(unsigned helper, HelperResult& result)
+{
+    MoveList<Move, MOVE_STACK_CAPACITY> moveStack;
+    MoveList<RootMove, MAX_LEGAL_MOVES> moves = rootMoves();
 
-        // sliding peice attacks
-        if (color == BLACK) {
-            for (int8 j = s - 8; j >= DIRECTION_BOUNDS[s][B]; j -= 8) {
-                if (peices[j]) {
-                    if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                        return false;
-                    }
-                    break;
-                }
-            }
+    uint8 skipSize = HELPER_SKIP_SIZE[(helper - 1) % HELPER_SKIP_SIZE.size()];
+    uint8 skipPhase = HELPER_SKIP_PHASE[(helper - 1) % HELPER_SKIP_PHASE.size()];
 
-            for (int8 j = s - 9; j >= DIRECTION_BOUNDS[s][BL]; j -= 9) {
-                if (peices[j]) {
-                    if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                        return false;
-                    }
-                    break;
-                }
-            }
+    for (uint8 depth = 0; depth < MAX_DEPTH - 1; ++depth) {
+        if ((depth + skipPhase) / skipSize % 2) {
+            continue;
+        }
 
-            for (int8 j = s - 7; j >= DIRECTION_BOUNDS[s][BR]; j -= 7) {
-                if (peices[j]) {
-                    if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                        return false;
-                    }
-                    break;
-                }
-            }
+        int32 alpha = -MAX_EVAL;
 
+        // Erase scores from last iteration (sortByScore will maintain order)
+        for (RootMove& rootMove : moves) {
+            rootMove.score = -MAX_EVAL;
         }
-        else {
-            for (int8 j = s + 8; j <= DIRECTION_BOUNDS[s][F]; j += 8) {
-                if (peices[j]) {
-                    if (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN) {
-                        return false;
-                    }
-                    break;
-                }
-            }
 
-            for (int8 j = s + 9; j <= DIRECTION_BOUNDS[s][FR]; j += 9) {
-                if (peices[j]) {
-                    if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                        return false;
-                    }
-                    break;
-                }
-            }
+        // Run search for each move
+        for (RootMove& rootMove : moves) {
+            makeMove(rootMove.move, 0);
+            rootMove.score = -search_std(1, depth, moveStack.data(), 0, -MAX_EVAL, -alpha);
+            unmakeMove(rootMove.move);
 
-            for (int8 j = s + 7; j <= DIRECTION_BOUNDS[s][FL]; j += 7) {
-                if (peices[j]) {
-                    if (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN) {
-                        return false;
-                    }
-                    break;
-                }
+            // Only completed iterations are reported
+            if (stopSearch->load(std::memory_order_relaxed)) {
+                result.nodes = nodesSearchedThisMove;
+                return;
             }
-        }
 
-        // King attacks
-        for (uint8 j = 1; j < KING_MOVES[s][0]; ++j) {
-            if (peices[KING_MOVES[s][j]] == enemy + KING) {
-                return false;
+            if (rootMove.score > alpha) {
+                alpha = rootMove.score;
             }
         }
-    }
 
-    move.setLegalFlag();
-    return true;
-}
+        // Sort moves in order by score
+        moves.sortByScore([](const RootMove& rootMove) { return rootMove.score; });
 
-void EngineV1_3::resetSearchMembers()
-{
-    nodesSearchedThisMove = 0;
+        result.move = moves[0].move;
+        result.score = moves[0].score;
+        result.depth = depth + 1;
+    }
+    result.nodes = nodesSearchedThisMove;
 }
 
-//SEARCH/EVAL METHODS
-std::uint64_t EngineV1_3::perft_h(uint8 plyFromRoot, uint8 depth, Move* moveStack, uint32 startMoves)
+int32 EngineV1_3::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, uint32 startMoves, int32 alpha, int32 beta)
 {
-    if (depth == 0) {
-        return 1ULL;
-    }
-
-    uint32 endMoves = startMoves;
-    generatePseudoLegalMoves(moveStack, endMoves);
-
-    std::uint64_t nodes = 0;
-
-    for (uint32 i = startMoves; i < endMoves; ++i) {
-        if (makeMove(moveStack[i], plyFromRoot)) {
-            nodes += perft_h(plyFromRoot + 1, depth - 1, moveStack, endMoves);
-            unmakeMove(moveStack[i]);
-        }
-    }
-
-    return nodes;
+    return pos.totalHalfmoves % 2 ? search_std<BLACK>(plyFromRoot, depth, moveStack, startMoves, alpha, beta) : search_std<WHITE>(plyFromRoot, depth, moveStack, startMoves, alpha, beta);
 }
 
+template <std::uint_fast8_t color>
 int32 EngineV1_3::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, uint32 startMoves, int32 alpha, int32 beta)
 {
     ++nodesSearchedThisMove;
@@ -2292,100 +1912,83 @@ int32 EngineV1_3::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, ui
     }
 
     // Get transposition table entry
-    TranspositionTable::Entry ttableEntry = ttable->getEntry(zobrist);
-    bool ttableEntryValid = ttableEntry.isHit(zobrist);
+    TranspositionTable::Entry ttableEntry = ttable->getEntry(pos.state->zobrist);
+    bool ttableEntryValid = ttableEntry.isHit(pos.state->zobrist);
 
     // Extract information from stored evaluation
     if (ttableEntryValid && ttableEntry.depth() >= depth) {
+        int32 ttableEval = evalFromTable(ttableEntry.eval(), plyFromRoot);
 
-        if (ttableEntry.info & ttableEntry.EXACT_VALUE) {
-            return ttableEntry.eval;
+        if (ttableEntry.evalType() == ttableEntry.EXACT_VALUE) {
+            return ttableEval;
         }
-        else if (ttableEntry.info & ttableEntry.LOWER_BOUND) {
-            if (ttableEntry.eval > alpha) {
-                alpha = ttableEntry.eval;
+        else if (ttableEntry.evalType() == ttableEntry.LOWER_BOUND) {
+            if (ttableEval > alpha) {
+                alpha = ttableEval;
             }
         }
         else {
-            if (ttableEntry.eval < beta) {
-                beta = ttableEntry.eval;
+            if (ttableEval < beta) {
+                beta = ttableEval;
             }
         }
 
         if (alpha >= beta) {
-            return ttableEntry.eval;
+            return ttableEval;
         }
     }
 
     if (depth == 0) {
-        return search_quiscence(plyFromRoot, moveStack, startMoves, alpha, beta);
+        return search_quiscence<color>(plyFromRoot, moveStack, startMoves, alpha, beta);
     }
 
     // BEGIN SEARCH
     int32 bestEval = -MAX_EVAL;
     Move bestMove;
     uint32 evalType = ttableEntry.UPPER_BOUND;
+
+    // PICK MOVES IN STAGES (TT move first)
+    bool inCheck = this->inCheck(color >> 3);
+    MovePicker movePicker(this, moveStack, startMoves, ttableEntryValid ? ttableEntry.move() : 0, killerMoves[plyFromRoot], inCheck);
     bool zeroLegalMoves = true;
+    Position parent;
 
-    // GENERATE MOVES
-    uint32 endMoves = startMoves;
-    bool inCheck = generatePseudoLegalMoves(moveStack, endMoves);
-    MoveOrderer pseudoLegalMoves(moveStack, startMoves, endMoves);
+    // Main loop
+    for (Move* move = movePicker.nextMove(); move; move = movePicker.nextMove()) {
+        zeroLegalMoves = false;
 
-    // Search the stored transposition table move first
-    if (ttableEntryValid && ttableEntry.move) {
-        Move move = Move(this, static_cast<uint8>(ttableEntry.move >> 8), static_cast<uint8>(ttableEntry.move & 0b11111111));
+        searchMakeMove<color>(*move, plyFromRoot, parent);
 
-        // omit move because it has already been searched
-        if (pseudoLegalMoves.omitMove(move) && makeMove(move, plyFromRoot)) {
-            zeroLegalMoves = false;
+        int32 eval = -search_std<color ^ BLACK>(plyFromRoot + 1, depth - 1, moveStack, movePicker.end(), -beta, -alpha);
 
-            bestMove = move;
-            bestEval = -search_std(plyFromRoot + 1, depth - 1, moveStack, endMoves, -beta, -alpha);
+        searchUnmakeMove<color>(*move, parent);
 
-            unmakeMove(move);
+        // The eval of an abandoned helper search is meaningless, so nothing is stored
+        if (stopSearch && stopSearch->load(std::memory_order_relaxed)) {
+            return 0;
+        }
 
-            if (bestEval >= beta) {
-                if (!ttableEntryValid || depth > ttableEntry.depth()) {
-                    ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, beta, ttableEntry.LOWER_BOUND, bestMove.start(), bestMove.target()), zobrist);
+        if (eval >= beta) {
+            // Remember quiet moves causing a cutoff to try early in sibling nodes
+            if (!capturedPeice(*move) && !move->promotion()) {
+                uint16 killer = move->encoded();
+                if (killerMoves[plyFromRoot][0] != killer) {
+                    killerMoves[plyFromRoot][1] = killerMoves[plyFromRoot][0];
+                    killerMoves[plyFromRoot][0] = killer;
                 }
-                return beta; // Cut node (lower bound)
             }
 
-            if (bestEval > alpha) {
-                alpha = bestEval;
-                evalType = ttableEntry.EXACT_VALUE;
-            }
+            ttable->storeEntry(TranspositionTable::Entry(pos.state->zobrist, depth, evalToTable(beta, plyFromRoot), ttableEntry.LOWER_BOUND, move->encoded()), pos.state->zobrist);
+            return beta; // Cut node (lower bound)
         }
-    }
 
-    // Sort moves
-    pseudoLegalMoves.initializeStrengthGuesses(this);
+        if (eval > bestEval) {
+            bestMove = *move;
+            bestEval = eval;
 
-    // Main loop
-    for (Move& move : pseudoLegalMoves) {
-        if (makeMove(move, plyFromRoot)) {
-            zeroLegalMoves = false;
-
-            int32 eval = -search_std(plyFromRoot + 1, depth - 1, moveStack, endMoves, -beta, -alpha);
-
-            unmakeMove(move);
-
-            if (eval >= beta) {
-                if (!ttableEntryValid || depth > ttableEntry.depth()) {
-                    ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, beta, ttableEntry.LOWER_BOUND, bestMove.start(), bestMove.target()), zobrist);
-                }
-                return beta; // Cut node (lower bound)
-            }
-
-            if (eval > bestEval) {
-                bestMove = move;
-                bestEval = eval;
-
-                if (eval > alpha) {
-                    alpha = eval;
-                    evalType = ttableEntry.EXACT_VALUE;
-                }
+            if (eval > alpha) {
+                alpha = eval;
+                evalType = ttableEntry.EXACT_VALUE;
             }
         }
     }
@@ -2394,37 +1997,63 @@ int32 EngineV1_3::search_std(uint8 plyFromRoot, uint8 depth, Move* moveStack, ui
         return inCheck ? -(MAX_EVAL - plyFromRoot) : 0;
     }
 
-    if (!ttableEntryValid || depth > ttableEntry.depth()) {
-        ttable->storeEntry(TranspositionTable::Entry(zobrist, depth, bestEval, evalType, bestMove.start(), bestMove.target()), zobrist);
-    }
+    ttable->storeEntry(TranspositionTable::Entry(pos.state->zobrist, depth, evalToTable(bestEval, plyFromRoot), evalType, bestMove.encoded()), pos.state->zobrist);
 
     return bestEval;
 }
 
+template <std::uint_fast8_t color>
 int32 EngineV1_3::search_quiscence(uint8 plyFromRoot, Move* moveStack, uint32 startMoves, int32 alpha, int32 beta)
 {
+    constexpr int32 side = color ? -1 : 1;
+
     ++nodesSearchedThisMove;
 
     // CHECK MAX DEPTH
     if (plyFromRoot > MAX_DEPTH) {
-        return evaluate(plyFromRoot) * colorToMove();
+        return evaluate(plyFromRoot) * side;
     }
 
     // GENERATE QUISCENCE MOVES
     uint32 endMoves = startMoves;
-    bool inCheck = generatePseudoLegalMoves(moveStack, endMoves, true);
+    bool inCheck = generateLegalMoves<color>(moveStack, endMoves, CAPTURES);
+
+    // Get transposition table entry (every entry is at least as deep as a quiscence search)
+    // Probing after generating the moves gives the entry prefetched by makeMove time to arrive
+    TranspositionTable::Entry ttableEntry = ttable->getEntry(pos.state->zobrist);
+    bool ttableEntryValid = ttableEntry.isHit(pos.state->zobrist);
+
+    if (ttableEntryValid) {
+        int32 ttableEval = evalFromTable(ttableEntry.eval(), plyFromRoot);
+
+        if (ttableEntry.evalType() == ttableEntry.EXACT_VALUE
+            || (ttableEntry.evalType() == ttableEntry.LOWER_BOUND && ttableEval >= beta)
+            || (ttableEntry.evalType() == ttableEntry.UPPER_BOUND && ttableEval <= alpha)) {
+            return ttableEval;
+        }
+    }
 
     // STATIC EVALUATION
     int32 bestEval;
-    bool zeroLegalMoves = true;
+    int32 staticEval = ttableEntryValid ? ttableEntry.staticEval() : ttableEntry.NO_STATIC_EVAL;
+    int32 startAlpha = alpha;
 
     if (inCheck) {
+        // All evasions are generated when in check
+        if (startMoves == endMoves) {
+            return -(MAX_EVAL - plyFromRoot);
+        }
         bestEval = -MAX_EVAL;
     }
     else {
-        bestEval = evaluate(plyFromRoot) * colorToMove();
+        // The static eval is kept in the entry so positions reached again skip the evaluation
+        if (staticEval == ttableEntry.NO_STATIC_EVAL) {
+            staticEval = std::clamp<int32>(evaluate(plyFromRoot) * side, -MATE_CUTOFF + 1, MATE_CUTOFF - 1);
+        }
+        bestEval = staticEval;
 
         if (bestEval >= beta) {
+            ttable->storeEntry(TranspositionTable::Entry(pos.state->zobrist, QUISCENCE_DEPTH, evalToTable(bestEval, plyFromRoot), ttableEntry.LOWER_BOUND, 0, static_cast<std::int16_t>(staticEval)), pos.state->zobrist);
             return bestEval;
         }
         if (bestEval > alpha) {
@@ -2433,34 +2062,45 @@ int32 EngineV1_3::search_quiscence(uint8 plyFromRoot, Move* moveStack, uint32 st
     }
 
     // ORDER MOVES
-    MoveOrderer pseudoLegalMoves(moveStack, startMoves, endMoves);
-    pseudoLegalMoves.initializeStrengthGuesses(this);
+    MoveOrderer orderedMoves(moveStack, moveScores, startMoves, endMoves);
+    orderedMoves.initializeStrengthGuesses(this);
+
+    // Search the stored move first
+    if (ttableEntryValid && ttableEntry.move()) {
+        for (uint32 i = startMoves; i < endMoves; ++i) {
+            if (moveStack[i].encoded() == ttableEntry.move()) {
+                moveScores[i] = INT32_MAX;
+                break;
+            }
+        }
+    }
 
     // SEARCH
-    for (Move& move : pseudoLegalMoves) {
-        if (makeMove(move, plyFromRoot)) {
-            zeroLegalMoves = false;
+    Position parent;
+    Move bestMove;
+    for (Move& move : orderedMoves) {
+        searchMakeMove<color>(move, plyFromRoot, parent);
 
-            int32 eval = isDrawByInsufficientMaterial() ? 0 : -search_quiscence(plyFromRoot + 1, moveStack, endMoves, -beta, -alpha);
+        int32 eval = isDrawByInsufficientMaterial() ? 0 : -search_quiscence<color ^ BLACK>(plyFromRoot + 1, moveStack, endMoves, -beta, -alpha);
 
-            unmakeMove(move);
+        searchUnmakeMove<color>(move, parent);
 
-            if (eval >= beta) {
-                return eval;
-            }
-            if (eval > bestEval) {
-                bestEval = eval;
+        if (eval >= beta) {
+            ttable->storeEntry(TranspositionTable::Entry(pos.state->zobrist, QUISCENCE_DEPTH, evalToTable(eval, plyFromRoot), ttableEntry.LOWER_BOUND, move.encoded(), static_cast<std::int16_t>(staticEval)), pos.state->zobrist);
+            return eval;
+        }
+        if (eval > bestEval) {
+            bestEval = eval;
 
-                if (eval > alpha) {
-                    alpha = eval;
-                }
+            if (eval > alpha) {
+                alpha = eval;
+                bestMove = move;
             }
         }
     }
 
-    if (inCheck && zeroLegalMoves) {
-        return -(MAX_EVAL - plyFromRoot);
-    }
+    uint8 evalType = bestEval > startAlpha ? ttableEntry.EXACT_VALUE : ttableEntry.UPPER_BOUND;
+    ttable->storeEntry(TranspositionTable::Entry(pos.state->zobrist, QUISCENCE_DEPTH, evalToTable(bestEval, plyFromRoot), evalType, bestMove.encoded(), static_cast<std::int16_t>(staticEval)), pos.state->zobrist);
 
     return bestEval;
 }
@@ -2495,16 +2135,16 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
     static constexpr int8 CASTLING_MOBILITY_BONUS = 5;
 
 
-    //int32 earlyGameEvaluation = earlygamePositionalMaterialInbalance;
-    //int32 endGameEvaluation = endgamePositionalMaterialInbalance;
+    //int32 earlyGameEvaluation = state->earlygamePositionalMaterialInbalance;
+    //int32 endGameEvaluation = state->endgamePositionalMaterialInbalance;
 
     /*
 
     // Endgame: king distance from center
-    int whiteRank = kingIndex[0] >> 3;
-    int whiteFIle = kingIndex[0] & 0b111;
-    int blackRank = kingIndex[1] >> 3;
-    int blackFIle = kingIndex[1] & 0b111;
+    int whiteRank = pos.kingIndex[0] >> 3;
+    int whiteFIle = pos.kingIndex[0] & 0b111;
+    int blackRank = pos.kingIndex[1] >> 3;
+    int blackFIle = pos.kingIndex[1] & 0b111;
 
     endGameEvaluation -= KING_DISTANCE_WEIGHT * (std::max(whiteRank, 7 - whiteRank) + std::max(whiteFIle, 7 - whiteFIle));
     endGameEvaluation += KING_DISTANCE_WEIGHT * (std::max(blackRank, 7 - blackFIle) + std::max(blackFIle, 7 - blackFIle));
@@ -2521,19 +2161,19 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
         int8 side = 1 - 2 * c;
         uint8 e = !c;
         uint8 enemy = e << 3;
-        uint8 king = kingIndex[c];
+        uint8 king = pos.kingIndex[c];
 
         // Look in each direction from king and calculate pins
         uint8 potentialPin = 0;
         for (int8 j = king - 8; j >= DIRECTION_BOUNDS[king][B]; j -= 8) {
-            if (!peices[j]) {
+            if (!pos.peices[j]) {
                 continue;
             }
-            if (!potentialPin && peices[j] >> 3 == c) {
+            if (!potentialPin && pos.peices[j] >> 3 == c) {
                 potentialPin = j;
                 continue;
             }
-            if (potentialPin && (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN)) {
+            if (potentialPin && (pos.peices[j] == enemy + ROOK || pos.peices[j] == enemy + QUEEN)) {
                 isPinned[potentialPin] = true;
                 earlyGameMobility -= side * PIN_MOBILITY_PENALTY;
                 endGameMobility -= side * PIN_MOBILITY_PENALTY;
@@ -2543,14 +2183,14 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
         potentialPin = 0;
         for (int8 j = king + 8; j <= DIRECTION_BOUNDS[king][F]; j += 8) {
-            if (!peices[j]) {
+            if (!pos.peices[j]) {
                 continue;
             }
-            if (!potentialPin && peices[j] >> 3 == c) {
+            if (!potentialPin && pos.peices[j] >> 3 == c) {
                 potentialPin = j;
                 continue;
             }
-            if (potentialPin && (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN)) {
+            if (potentialPin && (pos.peices[j] == enemy + ROOK || pos.peices[j] == enemy + QUEEN)) {
                 isPinned[potentialPin] = true;
                 earlyGameMobility -= side * PIN_MOBILITY_PENALTY;
                 endGameMobility -= side * PIN_MOBILITY_PENALTY;
@@ -2560,14 +2200,14 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
         potentialPin = 0;
         for (int8 j = king - 1; j >= DIRECTION_BOUNDS[king][L]; j -= 1) {
-            if (!peices[j]) {
+            if (!pos.peices[j]) {
                 continue;
             }
-            if (!potentialPin && peices[j] >> 3 == c) {
+            if (!potentialPin && pos.peices[j] >> 3 == c) {
                 potentialPin = j;
                 continue;
             }
-            if (potentialPin && (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN)) {
+            if (potentialPin && (pos.peices[j] == enemy + ROOK || pos.peices[j] == enemy + QUEEN)) {
                 isPinned[potentialPin] = true;
                 earlyGameMobility -= side * PIN_MOBILITY_PENALTY;
                 endGameMobility -= side * PIN_MOBILITY_PENALTY;
@@ -2577,14 +2217,14 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
         potentialPin = 0;
         for (int8 j = king + 1; j <= DIRECTION_BOUNDS[king][R]; j += 1) {
-            if (!peices[j]) {
+            if (!pos.peices[j]) {
                 continue;
             }
-            if (!potentialPin && peices[j] >> 3 == c) {
+            if (!potentialPin && pos.peices[j] >> 3 == c) {
                 potentialPin = j;
                 continue;
             }
-            if (potentialPin && (peices[j] == enemy + ROOK || peices[j] == enemy + QUEEN)) {
+            if (potentialPin && (pos.peices[j] == enemy + ROOK || pos.peices[j] == enemy + QUEEN)) {
                 isPinned[potentialPin] = true;
                 earlyGameMobility -= side * PIN_MOBILITY_PENALTY;
                 endGameMobility -= side * PIN_MOBILITY_PENALTY;
@@ -2594,14 +2234,14 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
         potentialPin = 0;
         for (int8 j = king - 9; j >= DIRECTION_BOUNDS[king][BL]; j -= 9) {
-            if (!peices[j]) {
+            if (!pos.peices[j]) {
                 continue;
             }
-            if (!potentialPin && peices[j] >> 3 == c) {
+            if (!potentialPin && pos.peices[j] >> 3 == c) {
                 potentialPin = j;
                 continue;
             }
-            if (potentialPin && (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN)) {
+            if (potentialPin && (pos.peices[j] == enemy + BISHOP || pos.peices[j] == enemy + QUEEN)) {
                 isPinned[potentialPin] = true;
                 earlyGameMobility -= side * PIN_MOBILITY_PENALTY;
                 endGameMobility -= side * PIN_MOBILITY_PENALTY;
@@ -2611,14 +2251,14 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
         potentialPin = 0;
         for (int8 j = king + 9; j <= DIRECTION_BOUNDS[king][FR]; j += 9) {
-            if (!peices[j]) {
+            if (!pos.peices[j]) {
                 continue;
             }
-            if (!potentialPin && peices[j] >> 3 == c) {
+            if (!potentialPin && pos.peices[j] >> 3 == c) {
                 potentialPin = j;
                 continue;
             }
-            if (potentialPin && (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN)) {
+            if (potentialPin && (pos.peices[j] == enemy + BISHOP || pos.peices[j] == enemy + QUEEN)) {
                 isPinned[potentialPin] = true;
                 earlyGameMobility -= side * PIN_MOBILITY_PENALTY;
                 endGameMobility -= side * PIN_MOBILITY_PENALTY;
@@ -2628,14 +2268,14 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
         potentialPin = 0;
         for (int8 j = king - 7; j >= DIRECTION_BOUNDS[king][BR]; j -= 7) {
-            if (!peices[j]) {
+            if (!pos.peices[j]) {
                 continue;
             }
-            if (!potentialPin && peices[j] >> 3 == c) {
+            if (!potentialPin && pos.peices[j] >> 3 == c) {
                 potentialPin = j;
                 continue;
             }
-            if (potentialPin && (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN)) {
+            if (potentialPin && (pos.peices[j] == enemy + BISHOP || pos.peices[j] == enemy + QUEEN)) {
                 isPinned[potentialPin] = true;
                 earlyGameMobility -= side * PIN_MOBILITY_PENALTY;
                 endGameMobility -= side * PIN_MOBILITY_PENALTY;
@@ -2645,14 +2285,14 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
         potentialPin = 0;
         for (int8 j = king + 7; j <= DIRECTION_BOUNDS[king][FL]; j += 7) {
-            if (!peices[j]) {
+            if (!pos.peices[j]) {
                 continue;
             }
-            if (!potentialPin && peices[j] >> 3 == c) {
+            if (!potentialPin && pos.peices[j] >> 3 == c) {
                 potentialPin = j;
                 continue;
             }
-            if (potentialPin && (peices[j] == enemy + BISHOP || peices[j] == enemy + QUEEN)) {
+            if (potentialPin && (pos.peices[j] == enemy + BISHOP || pos.peices[j] == enemy + QUEEN)) {
                 isPinned[potentialPin] = true;
                 earlyGameMobility -= side * PIN_MOBILITY_PENALTY;
                 endGameMobility -= side * PIN_MOBILITY_PENALTY;
@@ -2661,11 +2301,11 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
         }
 
         // Castling
-        if (!kingsideCastlingRightsLost[c]) {
+        if (pos.state->castlingRights & KINGSIDE_CASTLING << 2 * c) {
             uint8 castlingRank = 56 * c;
             bool roomToCastle = true;
             for (uint8 j = castlingRank + 5; j < castlingRank + 7; ++j) {
-                if (peices[j]) {
+                if (pos.peices[j]) {
                     roomToCastle = false;
                     break;
                 }
@@ -2674,11 +2314,11 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 earlyGameMobility += side * CASTLING_MOBILITY_BONUS;
             }
         }
-        if (!queensideCastlingRightsLost[c]) {
+        if (pos.state->castlingRights & QUEENSIDE_CASTLING << 2 * c) {
             uint8 castlingRank = 56 * c;
             bool roomToCastle = true;
             for (uint8 j = castlingRank + 3; j > castlingRank; --j) {
-                if (peices[j]) {
+                if (pos.peices[j]) {
                     roomToCastle = false;
                     break;
                 }
@@ -2691,27 +2331,27 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
     // Calculate mobility score for every peice
     for (uint8 s = 0; s < 64; ++s) {
-        if (peices[s] && !isPinned[s]) {
-            uint8 c = peices[s] >> 3;
+        if (pos.peices[s] && !isPinned[s]) {
+            uint8 c = pos.peices[s] >> 3;
             int8 side = 1 - 2 * c;
 
-            switch (peices[s] & 0b111) {
+            switch (pos.peices[s] & 0b111) {
             case PAWN: {
                 uint8 file = s % 8;
                 uint8 ahead = s + 8 - 16 * c;
 
                 // Pawn foward moves
-                if (!peices[ahead]) {
+                if (!pos.peices[ahead]) {
                     earlyGameMobility += side * PAWN_EARLY_MOBILITY_VALUE;
                     endGameMobility += side * PAWN_END_MOBILITY_VALUE;
                 }
 
                 // Pawn captures/defends
-                if (file != 0 && peices[ahead - 1]) {
+                if (file != 0 && pos.peices[ahead - 1]) {
                     earlyGameMobility += side * PAWN_EARLY_MOBILITY_VALUE;
                     endGameMobility += side * PAWN_END_MOBILITY_VALUE;
                 }
-                if (file != 7 && peices[ahead + 1]) {
+                if (file != 7 && pos.peices[ahead + 1]) {
                     earlyGameMobility += side * PAWN_EARLY_MOBILITY_VALUE;
                     endGameMobility += side * PAWN_END_MOBILITY_VALUE;
                 }
@@ -2726,7 +2366,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s - 8; t >= DIRECTION_BOUNDS[s][B]; t -= 8) {
                     earlyGameMobility += side * ROOK_VERTICAL_EARLY_MOBILITY_VALUE;
                     endGameMobility += side * ROOK_VERTICAL_END_MOBILITY_VALUE;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2734,7 +2374,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s + 8; t <= DIRECTION_BOUNDS[s][F]; t += 8) {
                     earlyGameMobility += side * ROOK_VERTICAL_EARLY_MOBILITY_VALUE;
                     endGameMobility += side * ROOK_VERTICAL_END_MOBILITY_VALUE;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2742,7 +2382,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s - 1; t >= DIRECTION_BOUNDS[s][L]; t -= 1) {
                     earlyGameMobility += side * ROOK_HORIZONTAL_EARLY_MOBILITY_VALUE;
                     endGameMobility += side * ROOK_HORIZONTAL_END_MOBILITY_VALUE;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2750,7 +2390,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s + 1; t <= DIRECTION_BOUNDS[s][R]; t += 1) {
                     earlyGameMobility += side * ROOK_HORIZONTAL_EARLY_MOBILITY_VALUE;
                     endGameMobility += side * ROOK_HORIZONTAL_END_MOBILITY_VALUE;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2761,7 +2401,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
             case KING: {
                 int8 early_mobility_value;
                 int8 end_mobility_value;
-                switch (peices[s] & 0b111) {
+                switch (pos.peices[s] & 0b111) {
                 case BISHOP:
                     early_mobility_value = BISHOP_EARLY_MOBILITY_VALUE;
                     end_mobility_value = BISHOP_END_MOBILITY_VALUE;
@@ -2779,7 +2419,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s - 9; t >= DIRECTION_BOUNDS[s][BL]; t -= 9) {
                     earlyGameMobility += side * early_mobility_value;
                     endGameMobility += side * end_mobility_value;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2787,7 +2427,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s + 9; t <= DIRECTION_BOUNDS[s][FR]; t += 9) {
                     earlyGameMobility += side * early_mobility_value;
                     endGameMobility += side * end_mobility_value;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2795,7 +2435,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s - 7; t >= DIRECTION_BOUNDS[s][BR]; t -= 7) {
                     earlyGameMobility += side * early_mobility_value;
                     endGameMobility += side * end_mobility_value;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2803,19 +2443,19 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s + 7; t <= DIRECTION_BOUNDS[s][FL]; t += 7) {
                     earlyGameMobility += side * early_mobility_value;
                     endGameMobility += side * end_mobility_value;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
 
-                if ((peices[s] & 0b111) == BISHOP) {
+                if ((pos.peices[s] & 0b111) == BISHOP) {
                     break;
                 }
 
                 for (int8 t = s - 8; t >= DIRECTION_BOUNDS[s][B]; t -= 8) {
                     earlyGameMobility += side * early_mobility_value;
                     endGameMobility += side * end_mobility_value;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2823,7 +2463,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s + 8; t <= DIRECTION_BOUNDS[s][F]; t += 8) {
                     earlyGameMobility += side * early_mobility_value;
                     endGameMobility += side * end_mobility_value;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2831,7 +2471,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s - 1; t >= DIRECTION_BOUNDS[s][L]; t -= 1) {
                     earlyGameMobility += side * early_mobility_value;
                     endGameMobility += side * end_mobility_value;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2839,7 +2479,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
                 for (int8 t = s + 1; t <= DIRECTION_BOUNDS[s][R]; t += 1) {
                     earlyGameMobility += side * early_mobility_value;
                     endGameMobility += side * end_mobility_value;
-                    if (peices[t]) {
+                    if (pos.peices[t]) {
                         break;
                     }
                 }
@@ -2854,7 +2494,7 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 
     */
 
-    //int32 psqtbEval = (material_stage_weight * earlyGameEvaluation + (128 - material_stage_weight) * endGameEvaluation) / 128;
+    //int32 psqtbEval = (pos.material_stage_weight * earlyGameEvaluation + (128 - pos.material_stage_weight) * endGameEvaluation) / 128;
 
     //int32 eval = (psqtbEval + nnue.foward(accumulatorBuffer[plyFromRoot])) >> 1;
 
@@ -2862,12 +2502,12 @@ int32 EngineV1_3::evaluate(uint8 plyFromRoot)
 }
 
 // MOVE ORDERING CLASS
-EngineV1_3::MoveOrderer::MoveOrderer(Move* moveStack, uint32 startMoves, uint32 endMoves) : moveStack(moveStack), startBounds(startMoves), endBounds(endMoves) {}
+EngineV1_3::MoveOrderer::MoveOrderer(Move* moveStack, int32* scores, uint32 startMoves, uint32 endMoves) : startBounds(startMoves), endBounds(endMoves), moveStack(moveStack), scores(scores) {}
 
 void EngineV1_3::MoveOrderer::initializeStrengthGuesses(EngineV1_3* engine)
 {
     for (uint32 i = startBounds; i < endBounds; ++i) {
-        generateStrengthGuess(engine, moveStack[i]);
+        scores[i] = generateStrengthGuess(engine, moveStack[i]);
     }
 }
 
@@ -2876,6 +2516,7 @@ bool EngineV1_3::MoveOrderer::omitMove(Move& move)
     for (uint32 i = startBounds; i < endBounds; ++i) {
         if (moveStack[i] == move) {
             std::swap(moveStack[i], moveStack[--endBounds]);
+            std::swap(scores[i], scores[endBounds]);
             return true;
         }
     }
@@ -2892,7 +2533,7 @@ bool EngineV1_3::MoveOrderer::contains(Move& move)
     return false;
 }
 
-void EngineV1_3::MoveOrderer::generateStrengthGuess(EngineV1_3* engine, EngineV1_3::Move& move)
+int32 EngineV1_3::MoveOrderer::generateStrengthGuess(EngineV1_3* engine, EngineV1_3::Move move)
 {
     /*
     if (move.promotion()) {
@@ -2908,41 +2549,46 @@ void EngineV1_3::MoveOrderer::generateStrengthGuess(EngineV1_3* engine, EngineV1
         endGameScore -= ENDGAME_PEICE_VALUE[move.moving()][move.target()];
     }
 
-    int32 score = engine->colorToMove() * (engine->material_stage_weight * earlyGameScore + (128 - engine->material_stage_weight) * endGameScore) >> 8;
+    int32 score = engine->colorToMove() * (engine->pos.material_stage_weight * earlyGameScore + (128 - engine->pos.material_stage_weight) * endGameScore) >> 8;
 
     //score += move.captured();
     */
 
-    int32 score = (engine->material_stage_weight * move.earlygamePositionalMaterialChange() + (128 - engine->material_stage_weight) * move.endgamePositionalMaterialChange()) >> 7;
+    int32 earlyPosmat;
+    int32 endPosmat;
+    engine->positionalMaterialChange(move, earlyPosmat, endPosmat);
+
+    int32 score = (engine->pos.material_stage_weight * earlyPosmat + (128 - engine->pos.material_stage_weight) * endPosmat) >> 7;
 
-    move.strengthGuess = score * engine->colorToMove();
+    return score * engine->colorToMove();
 }
 
 EngineV1_3::MoveOrderer::Iterator EngineV1_3::MoveOrderer::begin()
 {
     uint32 maxIndex = startBounds;
-    int32 maxStrength = moveStack[startBounds].strengthGuess;
+    int32 maxStrength = scores[startBounds];
 
     for (uint32 i = startBounds + 1; i < endBounds; ++i) {
-        if (moveStack[i].strengthGuess > maxStrength) {
-            maxStrength = moveStack[i].strengthGuess;
+        if (scores[i] > maxStrength) {
+            maxStrength = scores[i];
             maxIndex = i;
         }
     }
 
     if (maxIndex != startBounds) {
         std::swap(moveStack[startBounds], moveStack[maxIndex]);
+        std::swap(scores[startBounds], scores[maxIndex]);
     }
 
-    return Iterator(moveStack + startBounds, endBounds - startBounds, 0);
+    return Iterator(moveStack + startBounds, scores + startBounds, endBounds - startBounds, 0);
 }
 
 inline EngineV1_3::MoveOrderer::Iterator EngineV1_3::MoveOrderer::end()
 {
-    return Iterator(moveStack + startBounds, endBounds - startBounds, endBounds - startBounds);
+    return Iterator(moveStack + startBounds, scores + startBounds, endBounds - startBounds, endBounds - startBounds);
 }
 
-inline EngineV1_3::MoveOrderer::Iterator::Iterator(Move* start, uint32 size, uint32 currentIndex) : start(start), size(size), idx(currentIndex) {}
+inline EngineV1_3::MoveOrderer::Iterator::Iterator(Move* start, int32* scores, uint32 size, uint32 currentIndex) : start(start), scores(scores), size(size), idx(currentIndex) {}
 
 inline EngineV1_3::Move& EngineV1_3::MoveOrderer::Iterator::operator*()
 {
@@ -2951,17 +2597,18 @@ inline EngineV1_3::Move& EngineV1_3::MoveOrderer::Iterator::operator*()
 
 EngineV1_3::MoveOrderer::Iterator& EngineV1_3::MoveOrderer::Iterator::operator++() {
     uint32 maxIndex = ++idx;
-    int32 maxStrength = start[idx].strengthGuess;
+    int32 maxStrength = scores[idx];
 
     for (uint32 i = idx + 1; i < size; ++i) {
-        if (start[i].strengthGuess > maxStrength) {
-            maxStrength = start[i].strengthGuess;
+        if (scores[i] > maxStrength) {
+            maxStrength = scores[i];
             maxIndex = i;
         }
     }
 
     if (maxIndex != idx) {
         std::swap(start[idx], start[maxIndex]);
+        std::swap(scores[idx], scores[maxIndex]);
     }
 
     return *this;
@@ -2972,3 +2619,167 @@ inline bool EngineV1_3::MoveOrderer::Iterator::operator!=(const Iterator& other)
     return idx != other.idx;
 }
 // END MOVE ORDERING CLASS
+
+// MOVE PICKER CLASS
+EngineV1_3::MovePicker::MovePicker(EngineV1_3* engine, Move* moveStack, uint32 startMoves, uint16 ttMove, const uint16* killers, bool inCheck)
+    : engine(engine), moveStack(moveStack), scores(engine->moveScores), killers(killers), stage(TT_MOVE), inCheck(inCheck), current(startMoves), endMoves(startMoves), startMoves(startMoves), losingCapturesEnd(startMoves), ttMoveSearched(false), killersSearched(0), killerIndex(0)
+{
+    // Only try the TT move if it is legal in this position
+    if (!ttMove || !engine->decodeLegalMove(ttMove, moveStack, startMoves, this->ttMove)) {
+        stage = inCheck ? GENERATE_EVASIONS : GENERATE_CAPTURES;
+    }
+}
+
+EngineV1_3::Move* EngineV1_3::MovePicker::nextMove()
+{
+    while (true) {
+        switch (stage) {
+        case TT_MOVE:
+            stage = inCheck ? GENERATE_EVASIONS : GENERATE_CAPTURES;
+            ttMoveSearched = true;
+            return &ttMove;
+
+        case GENERATE_CAPTURES:
+            engine->generateLegalMoves(moveStack, endMoves, CAPTURES);
+            omitSearchedMoves();
+            scoreCaptures();
+            stage = WINNING_CAPTURES;
+            break;
+
+        case WINNING_CAPTURES:
+            while (current < endMoves) {
+                selectBest();
+                Move& move = moveStack[current++];
+
+                // Captures of a peice worth at least as much as the capturing peice can never lose material
+                if (PEICE_VALUES[engine->capturedPeice(move) & 0b111] < PEICE_VALUES[engine->movingPeice(move) & 0b111] && engine->staticExchangeEvaluation(move) < 0) {
+                    moveStack[losingCapturesEnd++] = move;
+                    continue;
+                }
+                return &move;
+            }
+            stage = KILLERS;
+            break;
+
+        case KILLERS:
+            while (killerIndex < 2) {
+                uint16 killer = killers[killerIndex++];
+                if (!killer || (ttMoveSearched && killer == ttMove.encoded())) {
+                    continue;
+                }
+
+                Move& move = killerMove[killersSearched];
+                if (engine->decodeLegalMove(killer, moveStack, endMoves, move) && !engine->capturedPeice(move) && !move.promotion()) {
+                    ++killersSearched;
+                    return &move;
+                }
+            }
+            stage = GENERATE_QUIETS;
+            break;
+
+        case GENERATE_QUIETS:
+            current = endMoves;
+            engine->generateLegalMoves(moveStack, endMoves, QUIETS);
+            omitSearchedMoves();
+            for (uint32 i = current; i < endMoves; ++i) {
+                scores[i] = MoveOrderer::generateStrengthGuess(engine, moveStack[i]);
+            }
+            stage = QUIET_MOVES;
+            break;
+
+        case QUIET_MOVES:
+            if (current < endMoves) {
+                selectBest();
+                return &moveStack[current++];
+            }
+            current = startMoves;
+            stage = LOSING_CAPTURES;
+            break;
+
+        case LOSING_CAPTURES:
+            if (current < losingCapturesEnd) {
+                return &moveStack[current++];
+            }
+            stage = DONE;
+            break;
+
+        case GENERATE_EVASIONS:
+            engine->generateLegalMoves(moveStack, endMoves, ALL_MOVES);
+            omitSearchedMoves();
+            scoreCaptures();
+            for (uint32 i = current; i < endMoves; ++i) {
+                if (!engine->capturedPeice(moveStack[i]) && !moveStack[i].promotion()) {
+                    // Quiet evasions after captures
+                    scores[i] = MoveOrderer::generateStrengthGuess(engine, moveStack[i]) - MAX_EVAL;
+                }
+            }
+            stage = EVASIONS;
+            break;
+
+        case EVASIONS:
+            if (current < endMoves) {
+                selectBest();
+                return &moveStack[current++];
+            }
+            stage = DONE;
+            break;
+
+        default:
+            return nullptr;
+        }
+    }
+}
+
+uint32 EngineV1_3::MovePicker::end() const noexcept
+{
+    return endMoves;
+}
+
+void EngineV1_3::MovePicker::scoreCaptures()
+{
+    for (uint32 i = current; i < endMoves; ++i) {
+        Move move = moveStack[i];
+        scores[i] = 8 * PEICE_VALUES[engine->capturedPeice(move) & 0b111] - PEICE_VALUES[engine->movingPeice(move) & 0b111];
+        if (move.promotion()) {
+            scores[i] += 8 * PEICE_VALUES[move.promotion()];
+        }
+    }
+}
+
+void EngineV1_3::MovePicker::omitSearchedMoves()
+{
+    uint32 i = current;
+    while (i < endMoves) {
+        bool searched = ttMoveSearched && moveStack[i] == ttMove;
+        for (uint8 k = 0; k < killersSearched; ++k) {
+            searched = searched || moveStack[i] == killerMove[k];
+        }
+
+        if (searched) {
+            moveStack[i] = moveStack[--endMoves];
+            scores[i] = scores[endMoves];
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+void EngineV1_3::MovePicker::selectBest()
+{
+    uint32 maxIndex = current;
+    int32 maxStrength = scores[current];
+
+    for (uint32 i = current + 1; i < endMoves; ++i) {
+        if (scores[i] > maxStrength) {
+            maxStrength = scores[i];
+            maxIndex = i;
+        }
+    }
+
+    if (maxIndex != current) {
+        std::swap(moveStack[current], moveStack[maxIndex]);
+        std::swap(scores[current], scores[maxIndex]);
+    }
+}
+// END MOVE PICKER CLASS
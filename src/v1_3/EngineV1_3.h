@@ -2,18 +2,35 @@
 #include "StandardEngine.h"
 #include "PerftTestableEngine.h"
 #include "StandardMove.h"
+#include "MoveList.h"
 #include "TranspositionTable.h"
+#include "PerftTable.h"
 #include "NNUE.h"
 
 #include <cstdint>
 #include <optional>
 #include <vector>
-#include <unordered_set>
+#include <memory>
 #include <string>
+#include <atomic>
+#include <thread>
+#include <type_traits>
 
 #define MAX_GAME_LENGTH 500
 #define MAX_DEPTH 32
-#define MOVE_STACK_SIZE 1500
+
+// Most plies perft can split the tree at into tasks for its worker threads
+#define MAX_PERFT_SPLIT_DEPTH 4
+
+// Search by copying the position for every move instead of unmaking the move (set to 1 with /D V1_3_COPY_MAKE=1)
+#ifndef V1_3_COPY_MAKE
+#define V1_3_COPY_MAKE 0
+#endif
+
+// Perft counts the legal moves one ply above the leaves instead of playing them (set to 0 to make every leaf move)
+#ifndef V1_3_PERFT_BULK_COUNT
+#define V1_3_PERFT_BULK_COUNT 1
+#endif
 
 class EngineV1_3 : public PerftTestableEngine
 {
@@ -28,6 +45,8 @@ public:
 
     std::vector<StandardMove> getLegalMoves() noexcept override;
 
+    std::size_t getLegalMoves(StandardMove* moves, std::size_t capacity) noexcept override;
+
     int colorToMove() noexcept override;
 
     StandardMove computerMove(std::chrono::milliseconds thinkTime) override;
@@ -46,6 +65,30 @@ public:
 
     std::uint64_t search_perft(std::chrono::milliseconds thinkTime) noexcept override;
 
+    // Split depth can be at most MAX_PERFT_SPLIT_DEPTH
+    std::vector<PerftSplit> perftSplit(int splitDepth) override;
+
+    // Sets the number of threads used by perft and the number of plies the tree is split at into tasks for them
+    // Defaults to every hardware thread and a split depth of 2 (1 thread runs perft on the engine itself)
+    void setPerftThreads(unsigned threads, unsigned splitDepth = 2);
+
+    // Sets the size of the perft hash table, which stores the node counts of subtrees so transpositions are only counted once
+    // The table is shared by the perft threads and kept between perft calls (0 removes it, which is the default)
+    void setPerftHash(std::size_t megabytes);
+
+    // Sets the number of threads used by computerMove and search_perft (lazy SMP)
+    // Helper threads search copies of the position at staggered depths and share the transposition table
+    // Defaults to 1, which keeps the search deterministic
+    void setSearchThreads(unsigned threads);
+
+    // Replaces the transposition table with an empty one of about the given size (rounded down to a power of two number of entries)
+    // Defaults to TranspositionTable::DEFAULT_MEGABYTES, must not be called during a search
+    void setSearchHash(std::size_t megabytes);
+
+    // Zeroes the transposition table on the given number of threads
+    // Only needed to search without any earlier results, as loading a position already stops entries from earlier games being hit
+    void clearSearchHash(unsigned threads);
+
     std::int_fast32_t testEval();
 
 private:
@@ -59,9 +102,14 @@ private:
     static constexpr std::uint_fast8_t QUEEN = 0b101;
     static constexpr std::uint_fast8_t KING = 0b110;
 
+    // Every ply of the search (capped at MAX_DEPTH) can add at most every legal move to the move stack
+    // Named apart from the MOVE_STACK_SIZE macros of the older engines, which can be included in the same file
+    static constexpr std::size_t MOVE_STACK_CAPACITY = (MAX_DEPTH + 1) * MAX_LEGAL_MOVES;
+
 
     // MOVE STRUCT
-    // struct for containing info about a move
+    // 16 bit move | 2 bits move type | 2 bits promotion peice | 6 bits target | 6 bits start |
+    // The moving and captured peices are read from the board when they are needed
     class Move
     {
     public:
@@ -71,41 +119,17 @@ private:
         // Ending square of the move [0, 63] -> [a1, h8]
         inline std::uint_fast8_t target() const noexcept;
 
-        // Peice and color of moving peice (peice that is on the starting square of the move
-        inline std::uint_fast8_t moving() const noexcept;
-
-        // Peice and color of captured peice
-        inline std::uint_fast8_t captured() const noexcept;
-
-        // Returns the color of the whose move is
-        inline std::uint_fast8_t color() const noexcept;
-
-        // Returs the color who the move is being played against
-        inline std::uint_fast8_t enemy() const noexcept;
-
         // In case of promotion, returns the peice value of the promoted peice
         inline std::uint_fast8_t promotion() const noexcept;
 
-        // Returns true if move is castling move
+        // Returns true if move is en passant move
         inline bool isEnPassant() const noexcept;
 
-        // Returns true if move is en passant move
+        // Returns true if move is castling move
         inline bool isCastling() const noexcept;
 
-        // Returns true of move is guarrenteed to be legal in the posiiton it was generated in
-        inline bool legalFlagSet() const noexcept;
-
-        // Sets the legal flag of the move
-        inline void setLegalFlag() noexcept;
-
-        inline void unSetLegalFlag() noexcept;
-
-        inline std::int_fast32_t earlygamePositionalMaterialChange() noexcept;
-
-        inline std::int_fast32_t endgamePositionalMaterialChange() noexcept;
-
-        // Heuristic geuss for the strength of the move (used for move ordering)
-        std::int_fast32_t strengthGuess;
+        // Raw 16 bit encoding of the move (used to store moves in the transposition table)
+        inline std::uint16_t encoded() const noexcept;
 
         // Override equality operator with other move
         inline bool operator==(const Move& other) const;
@@ -117,93 +141,156 @@ private:
         std::string toString() const;
 
         // CONSTRUCTORS
-        // Construct a new Move object from the given board and given flags (en_passant, castle, promotion, etc.)
-        Move(const EngineV1_3* board, std::uint_fast8_t start, std::uint_fast8_t target, std::uint_fast8_t givenFlags);
-
-        Move(const EngineV1_3* board, std::uint_fast8_t start, std::uint_fast8_t target);
+        // Construct a new Move object of the given type (promotionPeice is only used for promotions)
+        Move(std::uint_fast8_t start, std::uint_fast8_t target, std::uint16_t type = NONE, std::uint_fast8_t promotionPeice = KNIGHT);
 
         Move();
 
-        // FLAGS
-        static constexpr std::uint_fast8_t NONE = 0b00000000;
-        static constexpr std::uint_fast8_t PROMOTION = 0b00000111;
-        static constexpr std::uint_fast8_t LEGAL = 0b00001000;
-        static constexpr std::uint_fast8_t EN_PASSANT = 0b00010000;
-        static constexpr std::uint_fast8_t CASTLE = 0b00100000;
+        // MOVE TYPES
+        static constexpr std::uint16_t NONE = 0b00 << 14;
+        static constexpr std::uint16_t PROMOTION = 0b01 << 14;
+        static constexpr std::uint16_t EN_PASSANT = 0b10 << 14;
+        static constexpr std::uint16_t CASTLE = 0b11 << 14;
     private:
-        // Starting square of the move [0, 63] -> [a1, h8]
-        std::uint_fast8_t startSquare;
+        std::uint16_t data;
+    };
 
-        // Ending square of the move [0, 63] -> [a1, h8]
-        std::uint_fast8_t targetSquare;
+    // Subtree of a parallel perft, reached by playing the path from the root position
+    struct PerftTask
+    {
+        Move path[MAX_PERFT_SPLIT_DEPTH];
+        std::uint_fast8_t length;
 
-        // Peice and color of moving peice (peice that is on the starting square of the move
-        std::uint_fast8_t movingPeice;
+        // index of the root move the subtree belongs to (same index as enginePositionMoves)
+        std::uint_fast32_t rootMove;
+    };
 
-        // Peice and color of captured peice
-        std::uint_fast8_t capturedPeice;
+    // Root move with the score from the last search iteration
+    struct RootMove
+    {
+        Move move;
+        std::int_fast32_t score;
+    };
+
+    // Best move of the deepest iteration a helper search thread completed
+    struct HelperResult
+    {
+        Move move;
+        std::int_fast32_t score = 0;
+        std::uint_fast8_t depth = 0;
+        std::uint64_t nodes = 0;
+    };
+
+    // Lazy SMP helper threads, each searching its own copy of the engine until stop is set
+    struct SearchHelpers
+    {
+        std::atomic<bool> stop{ false };
+        std::vector<std::unique_ptr<EngineV1_3>> engines;
+        std::vector<HelperResult> results;
+        std::vector<std::thread> threads;
+    };
+
+    // STATE INFO STRUCT
+    // Information about a position that cant be recovered from the move when it is unmade
+    // A new state is pushed by makeMove, so unmakeMove only has to pop the stack
+    struct StateInfo
+    {
+        // zobrist hash of the position
+        std::uint64_t zobrist;
+
+        // Inbalance of peice placement, used for evaluation function
+        std::int_fast32_t earlygamePositionalMaterialInbalance;
+        std::int_fast32_t endgamePositionalMaterialInbalance;
 
-        // 8 bit flags of move
-        std::uint_fast8_t flags;
+        // | 1 bit black queenside | 1 bit black kingside | 1 bit white queenside | 1 bit white kingside |
+        std::uint_fast8_t castlingRights;
 
-        bool posmatInit;
+        // index of the square over which a pawn has just jumped over (0 if none)
+        std::uint_fast8_t enPassantSquare;
 
-        std::int_fast32_t earlyPosmat;
-        std::int_fast32_t endPosmat;
+        std::uint_fast8_t halfmovesSincePawnMoveOrCapture;
 
-        void initializePosmat() noexcept;
+        // peice and color captured by the move that led to the position
+        std::uint_fast8_t capturedPeice;
     };
 
-    // BOARD MEMBERS
-    // color and peice type at every square (index [0, 63] -> [a1, h8])
-    std::uint_fast8_t peices[64];
+    // POSITION STRUCT
+    // Board of a position, kept trivially copyable so that the search can copy it instead of unmaking moves
+    struct Position
+    {
+        // bitboard of every peice for either color (indexed the same as numPeices)
+        std::uint64_t peiceBitboards[15];
+
+        // bitboard of all of the peices of white and black (index 0 and 1)
+        std::uint64_t colorBitboards[2];
 
-    // contains the halfmove number when the kingside castling rights were lost for white or black (index 0 and 1)
-    std::int_fast32_t kingsideCastlingRightsLost[2];
+        // state of the position (points into the state stack, the states above it are overwritten by the next move)
+        StateInfo* state;
 
-    // contains the halfmove number when the queenside castling rights were lost for white or black (index 0 and 1)
-    std::int_fast32_t queensideCastlingRightsLost[2];
+        // total half moves since game start (half move is one player taking a turn)
+        std::uint_fast32_t totalHalfmoves;
 
-    // | 6 bits en-passant square | 6 bits halfmoves since pawn move/capture | 20 bits zobrist hash |
-    std::uint_fast32_t positionInfo[MAX_DEPTH + 50];
-    std::uint_fast8_t positionInfoIndex;
+        // color and peice type at every square (index [0, 63] -> [a1, h8])
+        std::uint_fast8_t peices[64];
 
-    // total half moves since game start (half move is one player taking a turn)
-    std::uint_fast32_t totalHalfmoves;
+        // index of the white and black king (index 0 and 1)
+        std::uint_fast8_t kingIndex[2];
 
-    // index of the white and black king (index 0 and 1)
-    std::uint_fast8_t kingIndex[2];
+        // number of peices on the board for either color and for every peice
+        std::uint_fast8_t numPeices[15];
+
+        // number of total on the board for either color
+        std::uint_fast8_t numTotalPeices[2];
+
+        // Total stage weight of the peices on the board, used for evaluation function
+        std::uint_fast8_t material_stage_weight;
+    };
 
-    // zobrist hash of the current position
-    std::uint_fast64_t zobrist;
+    static_assert(std::is_trivially_copyable<Position>::value, "Position is copied with memcpy by the copy-make search");
 
-    // number of peices on the board for either color and for every peice
-    std::uint_fast8_t numPeices[15];
+    // BOARD MEMBERS
+    // Board of the current position
+    Position pos;
 
-    // number of total on the board for either color 
-    std::uint_fast8_t numTotalPeices[2];
+    // states of the positions since the last pawn move or capture, followed by room for the positions of the search
+    std::vector<StateInfo> stateStack;
 
 
     // SEARCH/EVALUATION MEMBERS
     // Legal moves for the current position stored in the engine
-    std::vector<Move> enginePositionMoves;
-
-    // Inbalance of peice placement, used for evaluation function 
-    std::uint_fast8_t material_stage_weight;
-    std::int_fast32_t earlygamePositionalMaterialInbalance;
-    std::int_fast32_t endgamePositionalMaterialInbalance;
+    MoveList<Move, MAX_LEGAL_MOVES> enginePositionMoves;
 
     // Search data
     std::uint_fast32_t nodesSearchedThisMove;
 
-    // Transposition table
-    std::unique_ptr<TranspositionTable> ttable;
+    // Perft threads and the number of plies the tree is split at into tasks
+    unsigned perftThreads;
+    unsigned perftSplitDepth;
+
+    // Search threads (1 main thread and searchThreads - 1 helpers)
+    unsigned searchThreads;
+
+    // Set when the search of a helper thread should be abandoned (nullptr for the main thread)
+    const std::atomic<bool>* stopSearch;
+
+    // Two most recent quiet moves that caused a beta cutoff at every ply (Move::encoded)
+    std::uint_fast16_t killerMoves[MAX_DEPTH][2];
+
+    // Move ordering scores of the moves on the search move stack (same index as the move)
+    std::int_fast32_t moveScores[MOVE_STACK_CAPACITY];
+
+    // Transposition table (shared with the search helper copies of the engine)
+    std::shared_ptr<TranspositionTable> ttable;
+
+    // Perft node counts (shared with the perft thread copies of the engine)
+    std::shared_ptr<PerftTable> perftTable;
 
     // NNUE nueral network evaluator
     NNUE nnue;
 
     // Buffer for storing accumulators during the search
-    NNUE::Accumulator accumulatorBuffer[MAX_DEPTH];
+    // Quiscence search plays moves up to ply MAX_DEPTH and evaluates the position after them, one ply deeper
+    NNUE::Accumulator accumulatorBuffer[MAX_DEPTH + 2];
 
 
     // PRECOMPUTED DATA
@@ -224,31 +311,90 @@ private:
     static const std::uint_fast8_t PEICE_STAGE_WEIGHTS[15];
 
 
+    // Copies the board of another engine for a perft or search helper thread (the transposition table is shared, not copied)
+    EngineV1_3(const EngineV1_3& other);
+
     // BOARD METHODS
     // Initialize engine members for position
     void initializeFen(const std::string& fenString);
 
-    // Generates pseudo-legal moves for the current position
+    // Move types for generateLegalMoves
+    // CAPTURES includes all promotions, QUIETS is every other move
+    static constexpr std::uint_fast8_t CAPTURES = 0b01;
+    static constexpr std::uint_fast8_t QUIETS = 0b10;
+    static constexpr std::uint_fast8_t ALL_MOVES = 0b11;
+
+    // Generates legal moves for the current position
     // Populates the stack starting from the given index
-    // Doesnt generate all pseudo legal moves, omits moves that are guarenteed to be illegal
+    // Pins are resolved with the LINE table and king moves are checked against attacks with the king removed, so every move can be played directly
+    // Only moves of the given types (all evasions if in check) made by peices on startSquares are generated
     // Returns true of the king was in check
-    bool generatePseudoLegalMoves(Move* stack, std::uint_fast32_t& idx, bool generateOnlyCaptures = false) noexcept;
+    bool generateLegalMoves(Move* stack, std::uint_fast32_t& idx, std::uint_fast8_t moveTypes = ALL_MOVES, std::uint64_t startSquares = ~0ULL) noexcept;
 
-    // Generates legal moves for the current position
-    // Not as fast as pseudoLegalMoves() for searching
-    std::vector<Move> legalMoves();
+    // generateLegalMoves for the given color to move (pawn directions, promotion ranks and castling squares are compile time constants)
+    template <std::uint_fast8_t color>
+    bool generateLegalMoves(Move* stack, std::uint_fast32_t& idx, std::uint_fast8_t moveTypes = ALL_MOVES, std::uint64_t startSquares = ~0ULL) noexcept;
 
-    // Generates pseudo-legal captures for the current position
-    // Populates the stack starting from the given index
-    // Assumes the king is not in check
-    void generateCaptures(Move* stack, std::uint_fast32_t& idx, bool* pinnedPeices) const;
+    // Finds the legal move matching the encoded move (Move::encoded, including the promotion peice)
+    // The stack from idx is used as scratch space
+    // returns true and sets move if the move is legal in the current position
+    bool decodeLegalMove(std::uint_fast16_t encodedMove, Move* stack, std::uint_fast32_t idx, Move& move) noexcept;
+
+    // returns the material won by the side making the move after all captures on the target square are played out (static exchange evaluation)
+    std::int_fast32_t staticExchangeEvaluation(Move move) const noexcept;
+
+    // Replaces the moves with the legal moves for the current position
+    void legalMoves(MoveList<Move, MAX_LEGAL_MOVES>& moves);
+
+    // Returns the legal moves for the current position ordered by their strength guess
+    MoveList<RootMove, MAX_LEGAL_MOVES> rootMoves();
+
+    // returns the peice and color on the start square of the move (move must not have been played yet)
+    inline std::uint_fast8_t movingPeice(Move move) const noexcept;
+
+    // returns the peice and color captured by the move (move must not have been played yet)
+    inline std::uint_fast8_t capturedPeice(Move move) const noexcept;
+
+    // returns the change in earlygame and endgame positional material inbalance caused by the move (move must not have been played yet)
+    void positionalMaterialChange(Move move, std::int_fast32_t& earlygameChange, std::int_fast32_t& endgameChange) const noexcept;
+
+    // Adds the pawn move to the stack (all four promotions if the pawn lands on the last rank)
+    // Pinned pawns are only allowed to move along the line through their king
+    template <std::uint_fast8_t color>
+    void addPawnMoves(Move* stack, std::uint_fast32_t& idx, std::uint_fast8_t start, std::uint_fast8_t target, std::uint64_t pinned) const noexcept;
+
+    // returns a bitboard of the peices of either color attacking the given square
+    std::uint64_t attackersTo(std::uint_fast8_t square, std::uint64_t occupied) const noexcept;
 
-    // update the board based on the inputted move (must be pseudo legal)
-    // returns true if move was legal and process completed
-    bool makeMove(Move& move, std::uint_fast8_t plyFromRoot);
+    // returns a bitboard of the peices belonging to the inputted color which are pinned to their king
+    std::uint64_t pinnedPeices(std::uint_fast8_t c) const noexcept;
+
+    // toggles the squares of the moving and captured peices on the bitboards (castling rook not included)
+    template <std::uint_fast8_t color>
+    void toggleBitboards(Move move, std::uint_fast8_t moving, std::uint_fast8_t captured) noexcept;
+
+    // update the board based on the inputted move (must be legal, as generated by generateLegalMoves)
+    void makeMove(Move move, std::uint_fast8_t plyFromRoot);
+
+    // makeMove for a move played by the given color
+    // prefetchEntry starts loading the transposition table entry of the new position, for nodes that will probe it
+    template <std::uint_fast8_t color, bool prefetchEntry = true>
+    void makeMove(Move move, std::uint_fast8_t plyFromRoot);
 
     // update the board to reverse the inputted move (must have just been move previously played)
-    void unmakeMove(Move& move);
+    void unmakeMove(Move move);
+
+    // unmakeMove for a move played by the given color
+    template <std::uint_fast8_t color>
+    void unmakeMove(Move move);
+
+    // plays the move in the search (the board is first copied to parent when V1_3_COPY_MAKE is set)
+    template <std::uint_fast8_t color, bool prefetchEntry = true>
+    inline void searchMakeMove(Move move, std::uint_fast8_t plyFromRoot, Position& parent);
+
+    // takes back a move played by searchMakeMove, by copying back the parent board or unmaking the move
+    template <std::uint_fast8_t color>
+    inline void searchUnmakeMove(Move move, const Position& parent);
 
     // returns true if the last move has put the game into a forced draw (threefold repitition / 50 move rule / insufficient material)
     inline bool isDraw() const;
@@ -274,12 +420,6 @@ private:
     // return true if the king belonging to the inputted color is currently being attacked
     bool inCheck(std::uint_fast8_t c) const;
 
-    // return true if inputted pseudo legal move is legal in the current position
-    bool isLegal(Move& move);
-
-    // @param move pseudo legal castling move (castling rights are not lost and king is not in check)
-    // @return true if the castling move is legal in the current position
-    bool castlingMoveIsLegal(Move& move);
 
 
     // SEARCH/EVAL METHODS
@@ -287,13 +427,45 @@ private:
     // Resets the search parameters
     void resetSearchMembers();
 
+    // returns the key of the current position in the perft table (the zobrist hash does not include the en passant square)
+    inline std::uint64_t perftKey() const noexcept;
+
     // returns number of total positions a certain depth away
     std::uint64_t perft_h(std::uint_fast8_t plyFromRoot, std::uint_fast8_t depth, Move* moveStack, std::uint_fast32_t startMoves);
 
+    template <std::uint_fast8_t color>
+    std::uint64_t perft_h(std::uint_fast8_t plyFromRoot, std::uint_fast8_t depth, Move* moveStack, std::uint_fast32_t startMoves);
+
+    // Counts the nodes below every root move on perftThreads threads (rootNodes is indexed the same as enginePositionMoves)
+    // The tree is split into a task for every position splitDepth plies from the root, and idle threads steal tasks from the others
+    void perft_parallel(std::uint_fast8_t depth, std::uint_fast8_t splitDepth, std::vector<std::uint64_t>& rootNodes);
+
+    // returns a task for every position splitDepth plies from the root
+    std::vector<PerftTask> generatePerftTasks(std::uint_fast8_t splitDepth);
+
+    // Adds a task for every position reached from the end of the task path, until the path is splitDepth moves long
+    void generatePerftTasks(std::uint_fast8_t splitDepth, Move* moveStack, std::uint_fast32_t startMoves, PerftTask& task, std::vector<PerftTask>& tasks);
+
+    // Plays the task path and returns the number of positions depth plies from the root below it
+    std::uint64_t perftTask(const PerftTask& task, std::uint_fast8_t depth, Move* moveStack);
+
+    // Starts searchThreads - 1 helper threads searching the current position (does nothing with 1 search thread)
+    void startSearchHelpers(SearchHelpers& helpers);
+
+    // Stops the helper threads and waits for them to finish
+    void stopSearchHelpers(SearchHelpers& helpers);
+
+    // Iterative deepening on a helper copy of the engine until stop is set, skipping depths depending on the helper index
+    void helperSearch(unsigned helper, HelperResult& result);
+
     // Standard minimax search
     std::int_fast32_t search_std(std::uint_fast8_t plyFromRoot, std::uint_fast8_t depth, Move* moveStack, std::uint_fast32_t startMoves, std::int_fast32_t alpha, std::int_fast32_t beta);
 
+    template <std::uint_fast8_t color>
+    std::int_fast32_t search_std(std::uint_fast8_t plyFromRoot, std::uint_fast8_t depth, Move* moveStack, std::uint_fast32_t startMoves, std::int_fast32_t alpha, std::int_fast32_t beta);
+
     // Quiscence search
+    template <std::uint_fast8_t color>
     std::int_fast32_t search_quiscence(std::uint_fast8_t plyFromRoot, Move* moveStack, std::uint_fast32_t startMoves, std::int_fast32_t alpha, std::int_fast32_t beta);
 
     // Static evaluation function
@@ -305,10 +477,10 @@ private:
     {
     public:
         // Initializes the container
-        MoveOrderer(Move* moveStack, std::uint_fast32_t startMoves, std::uint_fast32_t endMoves);
+        MoveOrderer(Move* moveStack, std::int_fast32_t* scores, std::uint_fast32_t startMoves, std::uint_fast32_t endMoves);
 
-        // Generates a heuristic guess for how strong a move is based on the current position
-        static void generateStrengthGuess(EngineV1_3* engine, Move& move);
+        // Returns a heuristic guess for how strong a move is based on the current position
+        static std::int_fast32_t generateStrengthGuess(EngineV1_3* engine, Move move);
 
         // Generates heuristic scores for all of the moves in the stack within the bounds
         void initializeStrengthGuesses(EngineV1_3* engine);
@@ -321,7 +493,7 @@ private:
 
         class Iterator {
         public:
-            Iterator(Move* start, std::uint_fast32_t size, std::uint_fast32_t currentIndex);
+            Iterator(Move* start, std::int_fast32_t* scores, std::uint_fast32_t size, std::uint_fast32_t currentIndex);
 
             Move& operator*();
 
@@ -332,6 +504,7 @@ private:
 
         private:
             Move* start;
+            std::int_fast32_t* scores;
             std::uint_fast32_t size;
             std::uint_fast32_t idx;
         };
@@ -347,5 +520,75 @@ private:
         std::uint_fast32_t endBounds;
 
         Move* moveStack;
+
+        std::int_fast32_t* scores;
+    };
+
+    // MOVE PICKER CLASS
+    // Returns the moves of a search_std node in stages, generating each stage only once the previous one is used up
+    // TT move -> winning captures -> killers -> quiet moves -> losing captures (TT move -> evasions when in check)
+    class MovePicker
+    {
+    public:
+        // Moves are generated on the move stack starting from startMoves
+        MovePicker(EngineV1_3* engine, Move* moveStack, std::uint_fast32_t startMoves, std::uint_fast16_t ttMove, const std::uint_fast16_t* killers, bool inCheck);
+
+        // Returns the next move to search, or nullptr once every legal move has been returned
+        Move* nextMove();
+
+        // First free index of the move stack (the child node can use the stack from here)
+        std::uint_fast32_t end() const noexcept;
+
+    private:
+        // STAGES
+        static constexpr std::uint_fast8_t TT_MOVE = 0;
+        static constexpr std::uint_fast8_t GENERATE_CAPTURES = 1;
+        static constexpr std::uint_fast8_t WINNING_CAPTURES = 2;
+        static constexpr std::uint_fast8_t KILLERS = 3;
+        static constexpr std::uint_fast8_t GENERATE_QUIETS = 4;
+        static constexpr std::uint_fast8_t QUIET_MOVES = 5;
+        static constexpr std::uint_fast8_t LOSING_CAPTURES = 6;
+        static constexpr std::uint_fast8_t GENERATE_EVASIONS = 7;
+        static constexpr std::uint_fast8_t EVASIONS = 8;
+        static constexpr std::uint_fast8_t DONE = 9;
+
+        EngineV1_3* engine;
+
+        Move* moveStack;
+
+        std::int_fast32_t* scores;
+
+        const std::uint_fast16_t* killers;
+
+        std::uint_fast8_t stage;
+
+        bool inCheck;
+
+        // Index of the next move to return from the current stage
+        std::uint_fast32_t current;
+
+        // Moves of the current stage are in [current, endMoves)
+        std::uint_fast32_t endMoves;
+
+        // Losing captures are moved to [startMoves, losingCapturesEnd) until the end
+        std::uint_fast32_t startMoves;
+        std::uint_fast32_t losingCapturesEnd;
+
+        // Moves returned before the move generation stages (skipped when generated)
+        Move ttMove;
+        bool ttMoveSearched;
+
+        Move killerMove[2];
+        std::uint_fast8_t killersSearched;
+        std::uint_fast8_t killerIndex;
+
+        // Scores captures by most valuable victim / least valuable attacker
+        void scoreCaptures();
+
+        // Removes moves that were already returned from [current, endMoves)
+        void omitSearchedMoves();
+
+        // Moves the highest scoring move in [current, endMoves) to current
+        void selectBest();
     };
 };
\ No newline at end of file